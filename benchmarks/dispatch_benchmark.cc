@@ -0,0 +1,143 @@
+/*
+ * File: dispatch_benchmark.cc
+ * Project: libarc
+ * File Created: Sunday, 18th October 2026 2:30:48 am
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <arc/coro/eventloop.h>
+#include <arc/coro/task.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace arc::coro;
+
+// Measures how long dispatched coroutines wait before they start under skewed
+// load: every producer batch lands on one consumer and a few coroutines in it
+// block their event loop for a while, so that the rest of the batch queues up
+// behind them unless an idle consumer steals them or the producer places
+// coroutines by load.
+
+namespace {
+
+constexpr int kDefaultTaskCount = 4000;
+constexpr int kConsumerCount = 4;
+constexpr int kBatchSize = 8;
+constexpr int kSlowTaskInterval = 64;
+constexpr auto kSlowTaskTime = std::chrono::milliseconds(2);
+constexpr auto kBatchInterval = std::chrono::microseconds(200);
+
+std::vector<std::int64_t> latencies;
+std::atomic<int> finished_count{0};
+std::atomic<int> ready_consumer_count{0};
+
+Task<void> Work(int index, std::int64_t dispatched_time) {
+  latencies[index] = detail::GetCurrentTime() - dispatched_time;
+  if (index % kSlowTaskInterval == 0) {
+    // like a blocking call made by a slow request
+    std::this_thread::sleep_for(kSlowTaskTime);
+  }
+  finished_count++;
+  co_return;
+}
+
+Task<void> Consume(int task_count) {
+  EventLoop::GetLocalInstance().ResigerConsumer();
+  ready_consumer_count++;
+  while (finished_count < task_count) {
+    co_await SleepFor(std::chrono::milliseconds(1));
+  }
+  EventLoop::GetLocalInstance().DeResigerConsumer();
+}
+
+Task<void> Produce(int task_count) {
+  EventLoop::GetLocalInstance().ResigerProducer();
+  while (ready_consumer_count < kConsumerCount) {
+    co_await SleepFor(std::chrono::milliseconds(1));
+  }
+  for (int i = 0; i < task_count; i++) {
+    EventLoop::GetLocalInstance().Dispatch(Work(i, detail::GetCurrentTime()));
+    if ((i + 1) % kBatchSize == 0) {
+      co_await SleepFor(kBatchInterval);
+    }
+  }
+  EventLoop::GetLocalInstance().DeResigerProducer();
+}
+
+void Run(const std::string& name, int task_count, bool work_stealing,
+         DispatchPolicy policy = DispatchPolicy::ROUND_ROBIN) {
+  latencies.assign(task_count, 0);
+  finished_count = 0;
+  ready_consumer_count = 0;
+
+  std::vector<std::thread> consumers;
+  for (int i = 0; i < kConsumerCount; i++) {
+    consumers.emplace_back([task_count, work_stealing]() {
+      EventLoopOptions options;
+      options.work_stealing = work_stealing;
+      EventLoop::SetLocalOptions(options);
+      StartEventLoop(Consume(task_count));
+    });
+  }
+  std::thread producer([task_count, policy]() {
+    EventLoopOptions options;
+    options.dispatch_policy = policy;
+    EventLoop::SetLocalOptions(options);
+    StartEventLoop(Produce(task_count));
+  });
+  producer.join();
+  for (auto& consumer : consumers) {
+    consumer.join();
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile = [task_count](double p) {
+    return latencies[std::min<int>(task_count - 1, task_count * p)] / 1000.0;
+  };
+  std::cout << name << ": p50 " << percentile(0.5) << " us, p99 "
+            << percentile(0.99) << " us, p99.9 " << percentile(0.999)
+            << " us, max " << latencies.back() / 1000.0 << " us" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int task_count = (argc > 1 ? std::stoi(argv[1]) : kDefaultTaskCount);
+
+  std::cout << task_count << " tasks, " << kConsumerCount << " consumers, "
+            << "1 in " << kSlowTaskInterval << " blocks its loop for "
+            << kSlowTaskTime.count() << " ms" << std::endl;
+  Run("round robin  ", task_count, false);
+  Run("work stealing", task_count, true);
+  Run("least queued ", task_count, false, DispatchPolicy::LEAST_QUEUED);
+  Run("two choices  ", task_count, false,
+      DispatchPolicy::POWER_OF_TWO_CHOICES);
+  return 0;
+}
@@ -0,0 +1,115 @@
+/*
+ * File: dispatch_wakeup_benchmark.cc
+ * Project: libarc
+ * File Created: Sunday, 18th October 2026 2:44:41 am
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <arc/coro/eventloop.h>
+#include <arc/coro/task.h>
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace arc::coro;
+
+// Counts the eventfd writes made to wake up consumers while several producers
+// keep dispatching small coroutines. Every enqueue used to write once.
+
+namespace {
+
+constexpr int kDefaultTaskCount = 200000;
+constexpr int kConsumerCount = 4;
+constexpr int kProducerCount = 4;
+constexpr int kBatchSize = 4;
+
+std::atomic<int> finished_count{0};
+std::atomic<int> ready_consumer_count{0};
+
+Task<void> Work() {
+  finished_count++;
+  co_return;
+}
+
+Task<void> Consume(int task_count) {
+  EventLoop::GetLocalInstance().ResigerConsumer();
+  ready_consumer_count++;
+  while (finished_count < task_count) {
+    co_await SleepFor(std::chrono::milliseconds(1));
+  }
+  EventLoop::GetLocalInstance().DeResigerConsumer();
+}
+
+Task<void> Produce(int task_count) {
+  EventLoop::GetLocalInstance().ResigerProducer();
+  while (ready_consumer_count < kConsumerCount) {
+    co_await SleepFor(std::chrono::milliseconds(1));
+  }
+  for (int i = 0; i < task_count; i++) {
+    EventLoop::GetLocalInstance().Dispatch(Work());
+    if ((i + 1) % kBatchSize == 0) {
+      co_await Yield();
+    }
+  }
+  EventLoop::GetLocalInstance().DeResigerProducer();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int task_count = (argc > 1 ? std::stoi(argv[1]) : kDefaultTaskCount);
+  int per_producer_count = task_count / kProducerCount;
+  task_count = per_producer_count * kProducerCount;
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kConsumerCount; i++) {
+    threads.emplace_back(
+        [task_count]() { StartEventLoop(Consume(task_count)); });
+  }
+  for (int i = 0; i < kProducerCount; i++) {
+    threads.emplace_back([per_producer_count]() {
+      StartEventLoop(Produce(per_producer_count));
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+
+  auto stats = CoroutineDispatcher::GetInstance().GetStats();
+  std::cout << stats.dispatched_coroutines << " coroutines from "
+            << kProducerCount << " producers to " << kConsumerCount
+            << " consumers in " << elapsed << " ms" << std::endl;
+  std::cout << stats.enqueues << " enqueues, " << stats.notifications
+            << " eventfd writes, " << stats.NotificationsPerCoroutine()
+            << " writes per coroutine" << std::endl;
+  return 0;
+}
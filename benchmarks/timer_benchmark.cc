@@ -0,0 +1,164 @@
+/*
+ * File: timer_benchmark.cc
+ * Project: libarc
+ * File Created: Sunday, 18th October 2026 1:45:38 am
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <arc/coro/events/time_event.h>
+#include <arc/coro/utils/timing_wheel.h>
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <queue>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace arc::coro;
+
+// Compares the timing wheel with the binary heap the poller used before, for
+// the per-request timeout pattern: most timers are cancelled before expiring.
+
+namespace {
+
+constexpr int kDefaultTimerCount = 1000000;
+constexpr std::int64_t kMaxTimeout = 60000;
+constexpr int kCancelPercent = 90;
+
+struct Result {
+  double add_ns{0};
+  double cancel_ns{0};
+  double expire_ns{0};
+  std::size_t expired_count{0};
+};
+
+double NanosecondsPerOp(std::chrono::steady_clock::time_point start, int ops) {
+  auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+  return ops == 0 ? 0 : static_cast<double>(elapsed) / ops;
+}
+
+Result RunHeap(const std::vector<std::unique_ptr<TimeEvent>>& events,
+               const std::vector<bool>& is_cancelled) {
+  Result result;
+  // a cancelled timer can only be marked and skipped once it reaches the top
+  std::vector<bool> is_invalid(events.size(), false);
+  std::priority_queue<std::pair<std::int64_t, std::size_t>,
+                      std::vector<std::pair<std::int64_t, std::size_t>>,
+                      std::greater<std::pair<std::int64_t, std::size_t>>>
+      heap;
+
+  auto start = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < events.size(); i++) {
+    heap.push({events[i]->GetWakeupTime(), i});
+  }
+  result.add_ns = NanosecondsPerOp(start, events.size());
+
+  int cancelled = 0;
+  start = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < events.size(); i++) {
+    if (is_cancelled[i]) {
+      is_invalid[i] = true;
+      cancelled++;
+    }
+  }
+  result.cancel_ns = NanosecondsPerOp(start, cancelled);
+
+  start = std::chrono::steady_clock::now();
+  for (std::int64_t now = 0; now <= kMaxTimeout; now++) {
+    while (!heap.empty() && heap.top().first <= now) {
+      if (!is_invalid[heap.top().second]) {
+        result.expired_count++;
+      }
+      heap.pop();
+    }
+  }
+  result.expire_ns = NanosecondsPerOp(start, events.size() - cancelled);
+  return result;
+}
+
+Result RunTimingWheel(const std::vector<std::unique_ptr<TimeEvent>>& events,
+                      const std::vector<bool>& is_cancelled) {
+  Result result;
+  TimingWheel wheel(0);
+
+  auto start = std::chrono::steady_clock::now();
+  for (auto& event : events) {
+    wheel.Add(event.get());
+  }
+  result.add_ns = NanosecondsPerOp(start, events.size());
+
+  int cancelled = 0;
+  start = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < events.size(); i++) {
+    if (is_cancelled[i]) {
+      wheel.Remove(events[i].get());
+      cancelled++;
+    }
+  }
+  result.cancel_ns = NanosecondsPerOp(start, cancelled);
+
+  start = std::chrono::steady_clock::now();
+  for (std::int64_t now = 0; now <= kMaxTimeout; now++) {
+    while (wheel.PopExpired(now) != nullptr) {
+      result.expired_count++;
+    }
+  }
+  result.expire_ns = NanosecondsPerOp(start, events.size() - cancelled);
+  return result;
+}
+
+void PrintResult(const std::string& name, const Result& result) {
+  std::cout << name << ": add " << result.add_ns << " ns/op, cancel "
+            << result.cancel_ns << " ns/op, expire " << result.expire_ns
+            << " ns/op, expired " << result.expired_count << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int timer_count = (argc > 1 ? std::stoi(argv[1]) : kDefaultTimerCount);
+
+  std::mt19937_64 engine(0);
+  std::uniform_int_distribution<std::int64_t> timeout_dist(1, kMaxTimeout);
+  std::uniform_int_distribution<int> percent_dist(0, 99);
+  std::vector<std::unique_ptr<TimeEvent>> events;
+  std::vector<bool> is_cancelled;
+  events.reserve(timer_count);
+  is_cancelled.reserve(timer_count);
+  for (int i = 0; i < timer_count; i++) {
+    events.push_back(
+        std::make_unique<TimeEvent>(timeout_dist(engine), nullptr));
+    is_cancelled.push_back(percent_dist(engine) < kCancelPercent);
+  }
+
+  std::cout << timer_count << " timers, " << kCancelPercent
+            << "% cancelled before expiring" << std::endl;
+  PrintResult("binary heap ", RunHeap(events, is_cancelled));
+  PrintResult("timing wheel", RunTimingWheel(events, is_cancelled));
+  return 0;
+}
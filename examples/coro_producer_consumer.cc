@@ -30,6 +30,7 @@
 #include <arc/coro/task.h>
 #include <iostream>
 
+#include <functional>
 #include <queue>
 
 using namespace arc::coro;
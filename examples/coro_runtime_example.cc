@@ -0,0 +1,68 @@
+/*
+ * File: coro_runtime_example.cc
+ * Project: libarc
+ * File Created: Sunday, 18th October 2026 2:59:32 am
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <arc/coro/runtime.h>
+
+#include <iostream>
+#include <string>
+
+using namespace arc::io;
+using namespace arc::net;
+using namespace arc::coro;
+
+const std::string response =
+    "HTTP/1.1 200 OK\r\nContent-Length: 12\r\nContent-Type: "
+    "text/plain\r\n\r\nhello world\n";
+
+Task<void> HandleClient(
+    Socket<Domain::IPV4, Protocol::TCP, Pattern::ASYNC> sock) {
+  char buf[1024];
+  while (true) {
+    int received = co_await sock.Recv(buf, sizeof(buf));
+    if (received <= 0) {
+      break;
+    }
+    co_await sock.Send(response.c_str(), response.size());
+  }
+}
+
+// usage: arc_coro_runtime_example [thread count] [port] [cpu steering 0/1]
+int main(int argc, char** argv) {
+  RuntimeOptions options;
+  options.thread_count = (argc > 1 ? std::stoi(argv[1]) : 0);
+  std::uint16_t port = (argc > 2 ? std::stoi(argv[2]) : 8086);
+  bool is_cpu_steering = (argc > 3 && std::stoi(argv[3]) != 0);
+
+  Runtime runtime(options);
+  auto addr = runtime.Serve(Address<Domain::IPV4>("0.0.0.0", port),
+                            &HandleClient, is_cpu_steering);
+  std::cout << runtime.GetThreadCount() << " loops listen on port "
+            << addr.GetPort() << std::endl;
+  runtime.Join();
+  return 0;
+}
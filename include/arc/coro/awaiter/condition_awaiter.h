@@ -144,10 +144,7 @@ class [[nodiscard]] ConditionAwaiter {
                    const std::chrono::steady_clock::duration& timeout)
       : core_(core),
         lock_core_(lock_core),
-        abort_handle_(
-            std::chrono::duration_cast<std::chrono::milliseconds>(
-                (std::chrono::steady_clock::now() + timeout).time_since_epoch())
-                .count()) {}
+        abort_handle_(detail::ToWakeupTime(timeout)) {}
 
   bool await_ready() { return false; }
 
@@ -36,7 +36,9 @@
 #include <arc/coro/utils/cancellation_token.h>
 #include <arc/exception/io.h>
 
+#include <cerrno>
 #include <functional>
+#include <type_traits>
 #include <variant>
 
 namespace arc {
@@ -44,6 +46,8 @@ namespace coro {
 
 template <typename ReadyFunctor, typename ResumeFunctor>
 class [[nodiscard]] IOAwaiter {
+  using ResultType = typename std::invoke_result_t<ResumeFunctor>;
+
  public:
   IOAwaiter(ReadyFunctor&& ready_functor, ResumeFunctor&& resume_functor,
             int fd, io::IOType io_type)
@@ -74,23 +78,54 @@ class [[nodiscard]] IOAwaiter {
         resume_functor_(std::forward<ResumeFunctor>(resume_functor)),
         fd_(fd),
         io_type_(io_type),
-        abort_handle_(std::chrono::duration_cast<std::chrono::milliseconds>(
-                          (std::chrono::steady_clock::now() + sleep_time)
-                              .time_since_epoch())
-                          .count()) {}
+        abort_handle_(detail::ToWakeupTime(sleep_time)) {}
 
-  bool await_ready() { return ready_functor_(); }
+  bool await_ready() {
+    if (ready_functor_()) {
+      return true;
+    }
+    if constexpr (kIsRetryable_) {
+      // try the io before registering it, suspend only if it would block
+      auto& event_loop = EventLoop::GetLocalInstance();
+      if (event_loop.GetOptions().speculative_io) {
+        bool is_done = TryIO(this);
+        event_loop.RecordSpeculativeIO(is_done);
+        return is_done;
+      }
+    }
+    return false;
+  }
 
-  typename std::invoke_result_t<ResumeFunctor> await_resume() {
-    if (abort_handle_.index() != 0 && io_event_->IsInterrupted()) [[unlikely]] {
+  ResultType await_resume() {
+    if (abort_handle_.index() != 0 && io_event_ != nullptr &&
+        io_event_->IsInterrupted()) [[unlikely]] {
       return resume_interrupted_functor_();
     }
+    if constexpr (kIsRetryable_) {
+      if (has_result_) {
+        errno = result_errno_;
+        return result_;
+      }
+    }
     return resume_functor_();
   }
 
+  // tells the poller that resume_functor does the io until it would block, so
+  // an edge-triggered poller does not need to re-check the readiness
+  inline void SetDrainsFd() noexcept { is_draining_fd_ = true; }
+
   template <arc::concepts::PromiseT PromiseType>
   void await_suspend(std::coroutine_handle<PromiseType> handle) {
+    if (fd_ < 0) [[unlikely]] {
+      throw arc::exception::IOException("Waiting For IO of Invalid FD");
+    }
     io_event_ = new coro::IOEvent(fd_, io_type_, handle);
+    if constexpr (kIsRetryable_) {
+      io_event_->SetTryIO(&IOAwaiter::TryIO, this);
+    }
+    if (is_draining_fd_) {
+      io_event_->SetDrainsFd();
+    }
     auto event_loop = &EventLoop::GetLocalInstance();
     event_loop->AddIOEvent(io_event_);
     if (abort_handle_.index() == 1) [[unlikely]] {
@@ -105,6 +140,23 @@ class [[nodiscard]] IOAwaiter {
   }
 
  private:
+  // syscall like results (e.g. from recv and send) tell whether the io would
+  // block, so the poller is able to do the io before resuming the coroutine
+  constexpr static bool kIsRetryable_ =
+      std::is_integral_v<ResultType> && std::is_signed_v<ResultType>;
+
+  static bool TryIO(void* awaiter) {
+    auto self = static_cast<IOAwaiter*>(awaiter);
+    auto result = self->resume_functor_();
+    if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      return false;
+    }
+    self->result_ = result;
+    self->result_errno_ = errno;
+    self->has_result_ = true;
+    return true;
+  }
+
   io::IOType io_type_;
   int fd_;
 
@@ -116,6 +168,11 @@ class [[nodiscard]] IOAwaiter {
       abort_handle_;
 
   IOEvent* io_event_{nullptr};
+
+  std::conditional_t<kIsRetryable_, ResultType, int> result_{0};
+  int result_errno_{0};
+  bool has_result_{false};
+  bool is_draining_fd_{false};
 };
 
 }  // namespace coro
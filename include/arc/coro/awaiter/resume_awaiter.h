@@ -0,0 +1,96 @@
+/*
+ * File: resume_awaiter.h
+ * Project: libarc
+ * File Created: Sunday, 18th October 2026 3:06:45 am
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef LIBARC__CORO__AWAITER__RESUME_AWAITER_H
+#define LIBARC__CORO__AWAITER__RESUME_AWAITER_H
+
+#include <arc/concept/coro.h>
+#include <arc/coro/dispatcher.h>
+#include <arc/coro/eventloop.h>
+#include <arc/exception/base.h>
+
+#include <string>
+
+namespace arc {
+namespace coro {
+
+// waits on the current loop until the queue of the consumer has room, then
+// moves the coroutine there, or resumes it here if the consumer is gone
+void ResumeOnWhenSpace(EventLoopWakeUpHandle consumer_id,
+                       std::coroutine_handle<void> handle);
+
+// suspends the current coroutine and resumes the same frame on the consumer
+// event loop with the wake up handle, the loop it leaves does not wait for it.
+// It waits for room if the queue of the consumer is full, and goes on on the
+// current loop if the other one is being deregistered. Throws if the consumer
+// is not registered.
+class [[nodiscard]] ResumeOnAwaiter {
+ public:
+  ResumeOnAwaiter(EventLoopWakeUpHandle consumer_id)
+      : consumer_id_(consumer_id) {}
+
+  bool await_ready() {
+    if (EventLoop::GetLocalInstance().GetEventHandle() == consumer_id_) {
+      return true;
+    }
+    if (!CoroutineDispatcher::GetInstance().IsRegistered(consumer_id_)) {
+      throw arc::exception::detail::ExceptionBase(
+          "Consumer id " + std::to_string(consumer_id_) +
+          " is not registered.");
+    }
+    return false;
+  }
+
+  template <arc::concepts::PromiseT PromiseType>
+  bool await_suspend(std::coroutine_handle<PromiseType> handle) {
+    // the frame may be resumed and destroyed by the other loop once it is
+    // enqueued, so no member is touched afterwards
+    EventLoopWakeUpHandle consumer_id = consumer_id_;
+    switch (CoroutineDispatcher::GetInstance().TryEnqueueToSpecific(
+        consumer_id, handle)) {
+      case EnqueueResult::ENQUEUED:
+        return true;
+      case EnqueueResult::CLOSED:
+        return false;
+      case EnqueueResult::FULL:
+        break;
+    }
+    ResumeOnWhenSpace(consumer_id, handle);
+    return true;
+  }
+
+  void await_resume() {}
+
+ private:
+  EventLoopWakeUpHandle consumer_id_;
+};
+
+}  // namespace coro
+}  // namespace arc
+
+#endif
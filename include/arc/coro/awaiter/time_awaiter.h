@@ -41,10 +41,7 @@ namespace coro {
 class [[nodiscard]] TimeAwaiter {
  public:
   TimeAwaiter(const std::chrono::steady_clock::duration& sleep_time)
-      : next_wakeup_time_(std::chrono::duration_cast<std::chrono::milliseconds>(
-                              (std::chrono::steady_clock::now() + sleep_time)
-                                  .time_since_epoch())
-                              .count()) {}
+      : next_wakeup_time_(detail::ToWakeupTime(sleep_time)) {}
 
   bool await_ready() { return false; }
 
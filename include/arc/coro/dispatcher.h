@@ -29,6 +29,7 @@
 #ifndef LIBARC__CORO__DISPATCHER_H
 #define LIBARC__CORO__DISPATCHER_H
 
+#include <arc/coro/utils/epoch.h>
 #include <arc/exception/io.h>
 #include <arc/utils/data_structures/concurrentqueue.h>
 #include <unistd.h>
@@ -44,11 +45,18 @@ using experimental::suspend_never;
 #else
 #include <coroutine>
 #endif
+#include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <deque>
 #include <iostream>
+#include <memory>
 #include <mutex>
+#include <semaphore>
+#include <thread>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace arc {
@@ -68,19 +76,262 @@ class CoroutineConsumerToken {
   moodycamel::ConsumerToken token;
 };
 
+enum class DispatchPolicy {
+  ROUND_ROBIN = 0U,
+  // the consumer with the fewest queued coroutines
+  LEAST_QUEUED = 1U,
+  // the less loaded one of two random consumers, by their loop lag
+  POWER_OF_TWO_CHOICES = 2U,
+};
+
+struct DispatchStats {
+  std::uint64_t dispatched_coroutines{0};
+  // bulk enqueues, each of which used to write to the consumer's eventfd
+  std::uint64_t enqueues{0};
+  // eventfd writes to wake up sleeping consumers
+  std::uint64_t notifications{0};
+  // bounded enqueues rejected because the queue was full
+  std::uint64_t rejected_enqueues{0};
+  // the most coroutines ever queued in a single queue
+  int high_water_mark{0};
+
+  inline double NotificationsPerCoroutine() const {
+    return dispatched_coroutines == 0
+               ? 0
+               : static_cast<double>(notifications) / dispatched_coroutines;
+  }
+};
+
+enum class EnqueueResult {
+  ENQUEUED = 0U,
+  FULL = 1U,
+  // the consumer is not registered or is being deregistered
+  CLOSED = 2U,
+};
+
+// a coroutine dispatched by key, the key goes along so that the coroutine can
+// follow its key to another consumer
+struct KeyedCoroutine {
+  std::uint64_t key;
+  std::coroutine_handle<void> handle;
+};
+
+// a producer coroutine waiting for room in a full queue, it is resumed by
+// triggering its user event on its event loop
+struct SpaceWaiter {
+  int event_loop_id;
+  int event_id;
+  // released instead for a producer thread blocking outside event loops
+  std::binary_semaphore* semaphore{nullptr};
+};
+
+// coroutines which can run on any consumer, the owner takes them from the
+// front and idle consumers steal them from the back
+class StealableCoroutineDeque {
+ public:
+  StealableCoroutineDeque(std::atomic<int>* total_size)
+      : total_size_(total_size) {}
+
+  template <typename It>
+  void PushBulk(It it, int count) {
+    std::lock_guard guard(lock_);
+    for (int i = 0; i < count; i++, it++) {
+      deque_.push_back(*it);
+    }
+    UpdateSize(count);
+  }
+
+  std::size_t PopFront(std::coroutine_handle<void>* out, std::size_t count) {
+    if (GetSize() == 0) {
+      return 0;
+    }
+    std::lock_guard guard(lock_);
+    std::size_t popped = std::min(count, deque_.size());
+    for (std::size_t i = 0; i < popped; i++) {
+      out[i] = deque_.front();
+      deque_.pop_front();
+    }
+    UpdateSize(-static_cast<int>(popped));
+    return popped;
+  }
+
+  // moves the back half, rounded up, into the other deque
+  std::size_t StealHalfTo(StealableCoroutineDeque& thief) {
+    std::vector<std::coroutine_handle<void>> stolen;
+    {
+      std::lock_guard guard(lock_);
+      std::size_t count = (deque_.size() + 1) / 2;
+      stolen.assign(deque_.end() - count, deque_.end());
+      deque_.erase(deque_.end() - count, deque_.end());
+      UpdateSize(-static_cast<int>(count));
+    }
+    thief.PushBulk(stolen.begin(), stolen.size());
+    return stolen.size();
+  }
+
+  std::vector<std::coroutine_handle<void>> PopAll() {
+    std::lock_guard guard(lock_);
+    std::vector<std::coroutine_handle<void>> ret(deque_.begin(), deque_.end());
+    deque_.clear();
+    UpdateSize(-static_cast<int>(ret.size()));
+    return ret;
+  }
+
+  inline int GetSize() const { return size_.load(std::memory_order::acquire); }
+
+  inline bool IsIdle() const { return is_idle_.load(); }
+  // returns whether the idle state is changed
+  inline bool SetIdle(bool is_idle) {
+    return is_idle_.exchange(is_idle) != is_idle;
+  }
+
+ private:
+  inline void UpdateSize(int delta) {
+    size_.fetch_add(delta, std::memory_order::release);
+    total_size_->fetch_add(delta, std::memory_order::release);
+  }
+
+  std::mutex lock_;
+  std::deque<std::coroutine_handle<void>> deque_;
+  std::atomic<int> size_{0};
+  std::atomic<int>* total_size_{nullptr};
+  std::atomic<bool> is_idle_{false};
+};
+
 // MPSC queue
 class CoroutineQueue {
  public:
+  // bounded enqueues are limited to the capacity, the underlying queue leaves
+  // some slack for producers holding partially filled blocks
   CoroutineQueue(int capacity, int max_explicit_producer_count,
-                 int max_implicit_producer_count, EventLoopWakeUpHandle id)
-      : queue_(capacity, max_explicit_producer_count,
+                 int max_implicit_producer_count, EventLoopWakeUpHandle id,
+                 std::atomic<int>* total_stealable_size = nullptr)
+      : queue_(capacity * 2, max_explicit_producer_count,
                max_implicit_producer_count),
-        token_(queue_, id) {}
+        token_(queue_, id),
+        keyed_queue_(capacity * 2, max_explicit_producer_count,
+                     max_implicit_producer_count),
+        keyed_token_(keyed_queue_),
+        capacity_(capacity) {
+    if (total_stealable_size != nullptr) {
+      stealable_deque_ = new StealableCoroutineDeque(total_stealable_size);
+    }
+  }
+
+  ~CoroutineQueue() { delete stealable_deque_; }
+
+  inline bool IsWorkStealing() const { return stealable_deque_ != nullptr; }
+
+  // producers enter the queue before enqueuing or notifying its consumer, it
+  // fails once the queue is closed
+  inline bool Enter() {
+    in_flight_producers_.fetch_add(1);
+    if (is_closed_.load()) [[unlikely]] {
+      Leave();
+      return false;
+    }
+    return true;
+  }
+  inline void Leave() {
+    in_flight_producers_.fetch_sub(1, std::memory_order::release);
+  }
+
+  // called by the consumer before it blocks in polling, returns false if
+  // there is something to consume
+  bool Sleep() {
+    is_sleeping_.store(true);
+    std::atomic_thread_fence(std::memory_order::seq_cst);
+    if (GetRemainedItemsCount() > 0 ||
+        (IsWorkStealing() && stealable_deque_->GetSize() > 0)) {
+      is_sleeping_.store(false);
+      return false;
+    }
+    return true;
+  }
+  inline void WakeUp() {
+    is_sleeping_.store(false, std::memory_order::relaxed);
+  }
+
+  // called by producers after enqueuing, only the first producer enqueuing to
+  // a sleeping consumer needs to wake it up
+  inline bool RecordEnqueue(int count) {
+    enqueues_.fetch_add(1, std::memory_order::relaxed);
+    enqueued_items_.fetch_add(count, std::memory_order::relaxed);
+    std::atomic_thread_fence(std::memory_order::seq_cst);
+    if (is_sleeping_.load(std::memory_order::relaxed) &&
+        is_sleeping_.exchange(false)) {
+      notifications_.fetch_add(1, std::memory_order::relaxed);
+      return true;
+    }
+    return false;
+  }
+
+  // including the dequeued ones which have not been resumed yet
+  inline int GetQueuedCount() {
+    return GetRemainedItemsCount() +
+           dequeued_items_.load(std::memory_order::relaxed) +
+           (IsWorkStealing() ? stealable_deque_->GetSize() : 0);
+  }
+  inline void SetDequeuedCount(int count) {
+    dequeued_items_.store(count, std::memory_order::relaxed);
+  }
+
+  // published by the consumer, in nanoseconds
+  inline void SetLoopLag(std::int64_t lag) {
+    loop_lag_.store(lag, std::memory_order::relaxed);
+  }
+  // the start time of the current iteration, 0 if the consumer is not running
+  inline void SetBusySince(std::int64_t time) {
+    busy_since_.store(time, std::memory_order::relaxed);
+  }
+  // the recent loop lag or how long the current iteration has been running
+  inline std::int64_t GetLoad(std::int64_t now) const {
+    std::int64_t busy_since = busy_since_.load(std::memory_order::relaxed);
+    return std::max(loop_lag_.load(std::memory_order::relaxed),
+                    busy_since == 0 ? 0 : now - busy_since);
+  }
+
+  void AddStatsTo(DispatchStats& stats) const {
+    stats.dispatched_coroutines +=
+        enqueued_items_.load(std::memory_order::relaxed);
+    stats.enqueues += enqueues_.load(std::memory_order::relaxed);
+    stats.notifications += notifications_.load(std::memory_order::relaxed);
+    stats.rejected_enqueues +=
+        rejected_enqueues_.load(std::memory_order::relaxed);
+    stats.high_water_mark =
+        std::max(stats.high_water_mark, GetHighWaterMark());
+  }
+
+  // waits for the producers which have already entered
+  void Close() {
+    is_closed_.store(true);
+    while (in_flight_producers_.load() != 0) {
+      std::this_thread::yield();
+    }
+  }
+
+  // only valid if the queue is work stealing
+  inline StealableCoroutineDeque& GetStealableDeque() {
+    assert(stealable_deque_ != nullptr);
+    return *stealable_deque_;
+  }
 
   inline bool Enqueue(std::coroutine_handle<void>&& item) {
     bool ret = queue_.try_enqueue(item);
     if (ret) {
-      remained_items_.fetch_add(1, std::memory_order::release);
+      UpdateHighWaterMark(
+          remained_items_.fetch_add(1, std::memory_order::release) + 1);
+    }
+    return ret;
+  }
+
+  inline bool EnqueueKeyed(std::uint64_t key,
+                          std::coroutine_handle<void> item) {
+    bool ret = keyed_queue_.try_enqueue(KeyedCoroutine{key, item});
+    if (ret) {
+      remained_keyed_items_.fetch_add(1, std::memory_order::release);
+      UpdateHighWaterMark(
+          remained_items_.fetch_add(1, std::memory_order::release) + 1);
     }
     return ret;
   }
@@ -89,13 +340,62 @@ class CoroutineQueue {
   inline bool EnqueueBulk(It it, int count) {
     bool ret = queue_.try_enqueue_bulk(it, count);
     if (ret) {
-      remained_items_.fetch_add(count, std::memory_order::release);
+      UpdateHighWaterMark(
+          remained_items_.fetch_add(count, std::memory_order::release) +
+          count);
     }
     return ret;
   }
 
+  // fails instead of going beyond the capacity, concurrent producers may
+  // still overshoot it a little
+  inline bool EnqueueBounded(std::coroutine_handle<void>&& item) {
+    if (!HasSpace() || !Enqueue(std::move(item))) {
+      rejected_enqueues_.fetch_add(1, std::memory_order::relaxed);
+      return false;
+    }
+    return true;
+  }
+
+  inline bool HasSpace() { return GetRemainedItemsCount() < capacity_; }
+  inline int GetCapacity() const { return capacity_; }
+  inline int GetHighWaterMark() const {
+    return high_water_mark_.load(std::memory_order::relaxed);
+  }
+
+  // returns false without adding the waiter if there is room again or the
+  // queue is closed
+  bool AddSpaceWaiter(const SpaceWaiter& waiter) {
+    std::lock_guard guard(space_waiters_lock_);
+    if (is_closed_.load()) {
+      return false;
+    }
+    space_waiters_.push_back(waiter);
+    space_waiter_count_.store(space_waiters_.size());
+    std::atomic_thread_fence(std::memory_order::seq_cst);
+    if (HasSpace()) {
+      space_waiters_.pop_back();
+      space_waiter_count_.store(space_waiters_.size());
+      return false;
+    }
+    return true;
+  }
+
+  // called by the consumer after dequeuing
+  inline bool HasSpaceWaiters() {
+    std::atomic_thread_fence(std::memory_order::seq_cst);
+    return space_waiter_count_.load(std::memory_order::relaxed) > 0;
+  }
+
+  std::vector<SpaceWaiter> TakeSpaceWaiters() {
+    std::lock_guard guard(space_waiters_lock_);
+    space_waiter_count_.store(0);
+    return std::exchange(space_waiters_, {});
+  }
+
   inline bool Deque(std::coroutine_handle<void>&& item) {
-    bool ret = queue_.try_dequeue(token_.token, item);
+    bool ret = queue_.try_dequeue(token_.token, item) ||
+               DequeKeyedBulk(&item, 1) == 1;
     if (ret) {
       remained_items_.fetch_add(-1, std::memory_order::release);
     }
@@ -105,10 +405,28 @@ class CoroutineQueue {
   template <typename It>
   inline std::size_t DequeBulk(It it, int count) {
     int ret = queue_.try_dequeue_bulk(token_.token, it, count);
+    if (ret < count) {
+      ret += DequeKeyedBulk(it + ret, count - ret);
+    }
     remained_items_.fetch_add(-ret, std::memory_order::release);
     return ret;
   }
 
+  // called without the consumer, e.g. once the queue is closed, so that the
+  // keys are kept when the coroutines are moved to other consumers
+  std::vector<KeyedCoroutine> DequeAllKeyed() {
+    int count = remained_keyed_items_.load(std::memory_order::acquire);
+    std::vector<KeyedCoroutine> ret(count);
+    int dequeued = 0;
+    while (dequeued < count) {
+      dequeued += keyed_queue_.try_dequeue_bulk(
+          keyed_token_, ret.begin() + dequeued, count - dequeued);
+    }
+    remained_keyed_items_.fetch_add(-count, std::memory_order::release);
+    remained_items_.fetch_add(-count, std::memory_order::release);
+    return ret;
+  }
+
   std::vector<std::coroutine_handle<void>> DequeAll(int count) {
     if (count <= 0) {
       return std::vector<std::coroutine_handle<void>>();
@@ -119,6 +437,9 @@ class CoroutineQueue {
     while (remained_size > 0) {
       std::size_t this_size =
           queue_.try_dequeue_bulk(token_.token, now, remained_size);
+      if (static_cast<int>(this_size) < remained_size) {
+        this_size += DequeKeyedBulk(now + this_size, remained_size - this_size);
+      }
       now += this_size;
       remained_size -= this_size;
     }
@@ -135,185 +456,581 @@ class CoroutineQueue {
  private:
   moodycamel::ConcurrentQueue<std::coroutine_handle<void>> queue_;
   CoroutineConsumerToken token_;
+  // coroutines dispatched by key, counted in remained_items_ as well
+  moodycamel::ConcurrentQueue<KeyedCoroutine> keyed_queue_;
+  moodycamel::ConsumerToken keyed_token_;
+  std::atomic<int> remained_keyed_items_{0};
   std::atomic<int> remained_items_{0};
+  StealableCoroutineDeque* stealable_deque_{nullptr};
+  std::atomic<int> in_flight_producers_{0};
+  std::atomic<bool> is_closed_{false};
+  std::atomic<bool> is_sleeping_{false};
+  std::atomic<int> dequeued_items_{0};
+  std::atomic<std::int64_t> loop_lag_{0};
+  std::atomic<std::int64_t> busy_since_{0};
+  std::atomic<std::uint64_t> enqueues_{0};
+  std::atomic<std::uint64_t> enqueued_items_{0};
+  std::atomic<std::uint64_t> notifications_{0};
+
+  // only dequeues the handles, the caller updates remained_items_
+  template <typename It>
+  inline int DequeKeyedBulk(It it, int count) {
+    if (remained_keyed_items_.load(std::memory_order::acquire) <= 0) [[likely]] {
+      return 0;
+    }
+    KeyedCoroutine items[kMaxKeyedDequeCount_];
+    int ret = keyed_queue_.try_dequeue_bulk(
+        keyed_token_, items, std::min(count, kMaxKeyedDequeCount_));
+    for (int i = 0; i < ret; i++) {
+      *(it + i) = items[i].handle;
+    }
+    remained_keyed_items_.fetch_add(-ret, std::memory_order::release);
+    return ret;
+  }
+
+  inline void UpdateHighWaterMark(int size) {
+    int mark = high_water_mark_.load(std::memory_order::relaxed);
+    while (size > mark && !high_water_mark_.compare_exchange_weak(
+                              mark, size, std::memory_order::relaxed)) {
+    }
+  }
+
+  constexpr static int kMaxKeyedDequeCount_ = 64;
+
+  const int capacity_;
+  std::atomic<int> high_water_mark_{0};
+  std::atomic<std::uint64_t> rejected_enqueues_{0};
+  std::mutex space_waiters_lock_;
+  std::vector<SpaceWaiter> space_waiters_;
+  std::atomic<int> space_waiter_count_{0};
+};
+
+// registered consumers, never modified once published and only read inside
+// epoch read sections
+struct ConsumerSnapshot {
+  std::vector<EventLoopWakeUpHandle> ids;
+  std::vector<std::shared_ptr<CoroutineQueue>> queues;
+  // -1 if the node of the consumer is unknown
+  std::vector<int> numa_nodes;
+  // indices of the consumers on each numa node
+  std::vector<std::vector<std::size_t>> numa_node_consumers;
+  // indexed by consumer ids which are smaller than the vector size
+  std::vector<CoroutineQueue*> in_vec_queues;
+  std::unordered_map<EventLoopWakeUpHandle, CoroutineQueue*> extra_queues;
 };
 
 class CoroutineDispatcher {
  public:
   CoroutineDispatcher()
       : kMaxAllowedProducerCount_(std::thread::hardware_concurrency()) {
-    queues_.reserve(kMaxInVecQueueCount_);
-    for (int i = 0; i < kMaxInVecQueueCount_; i++) {
-      queues_.push_back(nullptr);
-    }
+    auto snapshot = new ConsumerSnapshot();
+    snapshot->in_vec_queues.resize(kMaxInVecQueueCount_, nullptr);
+    consumers_.store(snapshot);
   }
 
-  ~CoroutineDispatcher() {
-    for (EventLoopWakeUpHandle id : consumer_ids_) {
-      auto queue_ptr = GetCoroutineQueue(id);
-      assert(queue_ptr != nullptr);
-      delete queue_ptr;
-    }
-  }
+  ~CoroutineDispatcher() { delete consumers_.load(); }
 
   static CoroutineDispatcher& GetInstance();
 
   std::vector<EventLoopWakeUpHandle> GetAvailableDispatchDestinations() {
-    std::lock_guard guard(global_addition_lock_);
-    return consumer_ids_;
+    EpochReadGuard epoch_guard;
+    return consumers_.load()->ids;
   }
 
-  bool EnqueueToAny(std::coroutine_handle<void>&& handle) {
-    std::lock_guard guard(global_addition_lock_);
-    EventLoopWakeUpHandle next_consumer_id = GetNextConsumer();
-    auto queue_ptr = GetCoroutineQueue(next_consumer_id);
-    bool ret = queue_ptr->Enqueue(std::move(handle));
-    if (ret) {
-      NotifyEventLoop(next_consumer_id, 1);
-    }
-    return ret;
+  bool EnqueueToAny(std::coroutine_handle<void>&& handle,
+                    DispatchPolicy policy = DispatchPolicy::ROUND_ROBIN,
+                    int numa_node = -1) {
+    return EnqueueAllToAny(&handle, 1, policy, numa_node);
   }
 
   bool EnqueueToSpecific(EventLoopWakeUpHandle consumer_id,
                          std::coroutine_handle<void>&& handle) {
-    std::lock_guard guard(global_addition_lock_);
-    auto queue_ptr = GetCoroutineQueue(consumer_id);
-    bool ret = queue_ptr->Enqueue(std::move(handle));
-    if (ret) {
-      NotifyEventLoop(consumer_id, 1);
-    }
-    return ret;
+    return EnqueueAllToSpecific(consumer_id, &handle, 1);
   }
 
+  // consumers on the numa node are preferred if it is not -1
   template <typename It>
-  bool EnqueueAllToAny(It it, int count) {
-    std::lock_guard guard(global_addition_lock_);
-    return EnqueueAllToAnyNoLock(it, count);
+  bool EnqueueAllToAny(It it, int count,
+                       DispatchPolicy policy = DispatchPolicy::ROUND_ROBIN,
+                       int numa_node = -1) {
+    EpochReadGuard epoch_guard;
+    while (true) {
+      auto snapshot = consumers_.load();
+      if (snapshot->ids.empty()) {
+        throw arc::exception::detail::ExceptionBase("No consumer available");
+      }
+      std::size_t index = GetNextConsumer(*snapshot, policy, numa_node);
+      auto queue_ptr = snapshot->queues[index].get();
+      if (!queue_ptr->Enter()) [[unlikely]] {
+        // it is being deregistered, a newer snapshot has been published
+        continue;
+      }
+      bool ret = true;
+      if (queue_ptr->IsWorkStealing()) {
+        queue_ptr->GetStealableDeque().PushBulk(it, count);
+      } else {
+        ret = queue_ptr->EnqueueBulk(it, count);
+      }
+      if (ret) {
+        NotifyEventLoop(queue_ptr, snapshot->ids[index], count);
+      }
+      queue_ptr->Leave();
+      return ret;
+    }
   }
 
+  // fails if the consumer is being deregistered
   template <typename It>
   bool EnqueueAllToSpecific(EventLoopWakeUpHandle consumer_id, It it,
                             int count) {
-    std::lock_guard guard(global_addition_lock_);
-    auto queue_ptr = GetCoroutineQueue(consumer_id);
+    EpochReadGuard epoch_guard;
+    auto snapshot = consumers_.load();
+    auto queue_ptr = GetCoroutineQueue(*snapshot, consumer_id);
+    if (!queue_ptr->Enter()) [[unlikely]] {
+      return false;
+    }
     bool ret = queue_ptr->EnqueueBulk(it, count);
     if (ret) {
-      NotifyEventLoop(consumer_id, count);
+      NotifyEventLoop(queue_ptr, consumer_id, count);
     }
+    queue_ptr->Leave();
     return ret;
   }
 
-  CoroutineQueue* Register(EventLoopWakeUpHandle consumer_id) {
-    std::lock_guard guard(global_addition_lock_);
-    bool existed = consumer_id < kMaxInVecQueueCount_
-                       ? queues_[consumer_id] != nullptr
-                       : extra_queues_.find(consumer_id) != extra_queues_.end();
-    if (existed) {
+  // enqueues only if the queue of the consumer is below its capacity
+  EnqueueResult TryEnqueueToSpecific(EventLoopWakeUpHandle consumer_id,
+                                     std::coroutine_handle<void> handle) {
+    EpochReadGuard epoch_guard;
+    auto snapshot = consumers_.load();
+    auto queue_ptr = FindCoroutineQueue(*snapshot, consumer_id);
+    if (queue_ptr == nullptr || !queue_ptr->Enter()) [[unlikely]] {
+      return EnqueueResult::CLOSED;
+    }
+    bool ret = queue_ptr->EnqueueBounded(std::move(handle));
+    if (ret) {
+      NotifyEventLoop(queue_ptr, consumer_id, 1);
+    }
+    queue_ptr->Leave();
+    return ret ? EnqueueResult::ENQUEUED : EnqueueResult::FULL;
+  }
+
+  // the waiter is resumed once the consumer dequeues, returns false without
+  // adding it if the queue has room again or the consumer is gone
+  bool AddSpaceWaiter(EventLoopWakeUpHandle consumer_id,
+                      const SpaceWaiter& waiter) {
+    EpochReadGuard epoch_guard;
+    auto snapshot = consumers_.load();
+    auto queue_ptr = FindCoroutineQueue(*snapshot, consumer_id);
+    if (queue_ptr == nullptr || !queue_ptr->Enter()) [[unlikely]] {
+      return false;
+    }
+    bool ret = queue_ptr->AddSpaceWaiter(waiter);
+    queue_ptr->Leave();
+    return ret;
+  }
+
+  // the same key goes to the same consumer as long as it is registered, a
+  // consumer leaving only moves its own keys and a consumer joining only takes
+  // its share of keys from the others
+  EventLoopWakeUpHandle GetConsumerByKey(std::uint64_t key) {
+    EpochReadGuard epoch_guard;
+    auto snapshot = consumers_.load();
+    if (snapshot->ids.empty()) {
+      throw arc::exception::detail::ExceptionBase("No consumer available");
+    }
+    return snapshot->ids[GetConsumerIndexByKey(*snapshot, key)];
+  }
+
+  // enqueues to the consumer of the key in the latest snapshot, retries with
+  // a newer one if the consumer is being deregistered
+  bool EnqueueToKey(std::uint64_t key, std::coroutine_handle<void> handle) {
+    EpochReadGuard epoch_guard;
+    while (true) {
+      auto snapshot = consumers_.load();
+      if (snapshot->ids.empty()) {
+        throw arc::exception::detail::ExceptionBase("No consumer available");
+      }
+      std::size_t index = GetConsumerIndexByKey(*snapshot, key);
+      auto queue_ptr = snapshot->queues[index].get();
+      if (!queue_ptr->Enter()) [[unlikely]] {
+        continue;
+      }
+      bool ret = queue_ptr->EnqueueKeyed(key, handle);
+      if (ret) {
+        NotifyEventLoop(queue_ptr, snapshot->ids[index], 1);
+      }
+      queue_ptr->Leave();
+      return ret;
+    }
+  }
+
+  bool IsRegistered(EventLoopWakeUpHandle consumer_id) {
+    EpochReadGuard epoch_guard;
+    return FindCoroutineQueue(*consumers_.load(), consumer_id) != nullptr;
+  }
+
+  // the most coroutines ever queued for the consumer
+  int GetHighWaterMark(EventLoopWakeUpHandle consumer_id) {
+    EpochReadGuard epoch_guard;
+    auto snapshot = consumers_.load();
+    return GetCoroutineQueue(*snapshot, consumer_id)->GetHighWaterMark();
+  }
+
+  // the consumer the policy would dispatch to next
+  EventLoopWakeUpHandle SelectConsumer(
+      DispatchPolicy policy = DispatchPolicy::ROUND_ROBIN,
+      int numa_node = -1) {
+    EpochReadGuard epoch_guard;
+    auto snapshot = consumers_.load();
+    if (snapshot->ids.empty()) {
+      throw arc::exception::detail::ExceptionBase("No consumer available");
+    }
+    return snapshot->ids[GetNextConsumer(*snapshot, policy, numa_node)];
+  }
+
+  // a work stealing consumer keeps coroutines dispatched to any consumer in a
+  // deque which idle work stealing consumers can steal from
+  CoroutineQueue* Register(EventLoopWakeUpHandle consumer_id,
+                           bool is_work_stealing = false, int numa_node = -1) {
+    std::unique_lock guard(registration_lock_);
+    auto snapshot = consumers_.load();
+    if (FindCoroutineQueue(*snapshot, consumer_id) != nullptr) {
       throw arc::exception::detail::ExceptionBase(
           "Consumer id " + std::to_string(consumer_id) +
           " has already been registered.");
     }
 
-    auto queue_ptr = new CoroutineQueue(kCoroutineQueueDefaultSize_, 0,
-                                        kMaxAllowedProducerCount_, consumer_id);
+    auto queue_ptr = std::make_shared<CoroutineQueue>(
+        kCoroutineQueueDefaultSize_, 0, kMaxAllowedProducerCount_, consumer_id,
+        is_work_stealing ? &stealable_items_ : nullptr);
+    auto new_snapshot = new ConsumerSnapshot(*snapshot);
     if (consumer_id < kMaxInVecQueueCount_) {
-      queues_[consumer_id] = queue_ptr;
+      new_snapshot->in_vec_queues[consumer_id] = queue_ptr.get();
     } else {
-      extra_queues_[consumer_id] = queue_ptr;
+      new_snapshot->extra_queues[consumer_id] = queue_ptr.get();
     }
-    consumer_ids_.push_back(consumer_id);
-    consumer_id_itr_ = consumer_ids_.begin();
-    return queue_ptr;
+    new_snapshot->ids.push_back(consumer_id);
+    new_snapshot->queues.push_back(queue_ptr);
+    new_snapshot->numa_nodes.push_back(numa_node);
+    IndexNumaNodes(*new_snapshot);
+    consumers_.store(new_snapshot);
+    guard.unlock();
+
+    // writers only replace the snapshot under the lock, so it is only freed
+    // here
+    SynchronizeEpoch();
+    delete snapshot;
+    return queue_ptr.get();
   }
 
-  void DeRegister(EventLoopWakeUpHandle consumer_id) {
-    std::lock_guard guard(global_addition_lock_);
-    bool existed = consumer_id < kMaxInVecQueueCount_
-                       ? queues_[consumer_id] != nullptr
-                       : extra_queues_.find(consumer_id) != extra_queues_.end();
-    if (!existed) {
+  // returns the producers waiting for room in the queue, which have to be
+  // resumed by the caller
+  std::vector<SpaceWaiter> DeRegister(EventLoopWakeUpHandle consumer_id) {
+    std::unique_lock guard(registration_lock_);
+    auto snapshot = consumers_.load();
+    auto queue_ptr = FindCoroutineQueue(*snapshot, consumer_id);
+    if (queue_ptr == nullptr) {
       throw arc::exception::detail::ExceptionBase(
           "Consumer id " + std::to_string(consumer_id) +
           " has not been registered before.");
     }
 
-    auto queue_ptr = GetCoroutineQueue(consumer_id);
-    auto coroutines = queue_ptr->DequeAll(queue_ptr->GetRemainedItemsCount());
-
+    auto new_snapshot = new ConsumerSnapshot(*snapshot);
     if (consumer_id < kMaxInVecQueueCount_) {
-      delete queues_[consumer_id];
-      queues_[consumer_id] = nullptr;
+      new_snapshot->in_vec_queues[consumer_id] = nullptr;
     } else {
-      delete extra_queues_[consumer_id];
-      extra_queues_.erase(consumer_id);
+      new_snapshot->extra_queues.erase(consumer_id);
     }
-
-    for (auto itr = consumer_ids_.begin(); itr != consumer_ids_.end(); itr++) {
-      if (*itr == consumer_id) {
-        consumer_id_itr_ = consumer_ids_.erase(itr);
-        if (consumer_id_itr_ == consumer_ids_.end()) {
-          consumer_id_itr_ = consumer_ids_.begin();
-        }
+    for (std::size_t i = 0; i < new_snapshot->ids.size(); i++) {
+      if (new_snapshot->ids[i] == consumer_id) {
+        new_snapshot->ids.erase(new_snapshot->ids.begin() + i);
+        new_snapshot->queues.erase(new_snapshot->queues.begin() + i);
+        new_snapshot->numa_nodes.erase(new_snapshot->numa_nodes.begin() + i);
         break;
       }
     }
+    IndexNumaNodes(*new_snapshot);
+    bool has_consumer = !new_snapshot->ids.empty();
+    consumers_.store(new_snapshot);
+    guard.unlock();
+
+    // the old snapshot holds the last reference to the queue, so the queue is
+    // freed together with it once no producer can see them
+    SynchronizeEpoch();
+    std::unique_ptr<const ConsumerSnapshot> old_snapshot(snapshot);
+    queue_ptr->Close();
+    auto space_waiters = queue_ptr->TakeSpaceWaiters();
+    auto keyed_coroutines = queue_ptr->DequeAllKeyed();
+    auto coroutines = queue_ptr->DequeAll(queue_ptr->GetRemainedItemsCount());
+    if (queue_ptr->IsWorkStealing()) {
+      SetIdle(queue_ptr, false);
+      auto stealable_coroutines = queue_ptr->GetStealableDeque().PopAll();
+      coroutines.insert(coroutines.end(), stealable_coroutines.begin(),
+                        stealable_coroutines.end());
+    }
+
+    {
+      std::lock_guard stats_guard(registration_lock_);
+      queue_ptr->AddStatsTo(deregistered_stats_);
+    }
 
-    if (!consumer_ids_.empty() && !coroutines.empty()) {
-      EnqueueAllToAnyNoLock(coroutines.begin(), coroutines.size());
+    if (has_consumer && !coroutines.empty()) {
+      EnqueueAllToAny(coroutines.begin(), coroutines.size());
     }
+    // keyed ones follow their keys to the new owners
+    for (auto& [key, handle] : keyed_coroutines) {
+      if (has_consumer && !EnqueueToKey(key, handle)) [[unlikely]] {
+        EnqueueToAny(std::move(handle));
+      }
+    }
+    return space_waiters;
+  }
+
+  // steals from the work stealing consumer with the most stealable coroutines,
+  // returns the number of coroutines moved into the thief's deque
+  std::size_t Steal(EventLoopWakeUpHandle thief_id) {
+    if (stealable_items_.load(std::memory_order::acquire) <= 0) [[likely]] {
+      return 0;
+    }
+    EpochReadGuard epoch_guard;
+    auto snapshot = consumers_.load();
+    auto thief = GetCoroutineQueue(*snapshot, thief_id);
+    assert(thief->IsWorkStealing());
+    CoroutineQueue* victim = nullptr;
+    int victim_size = 0;
+    for (auto& queue : snapshot->queues) {
+      if (queue.get() == thief || !queue->IsWorkStealing()) {
+        continue;
+      }
+      int size = queue->GetStealableDeque().GetSize();
+      if (size > victim_size) {
+        victim = queue.get();
+        victim_size = size;
+      }
+    }
+    if (victim == nullptr) {
+      return 0;
+    }
+    return victim->GetStealableDeque().StealHalfTo(thief->GetStealableDeque());
+  }
+
+  // an idle work stealing consumer is about to block and can be woken up by
+  // busy consumers to steal from them
+  inline void SetIdle(CoroutineQueue* queue, bool is_idle) {
+    auto& deque = queue->GetStealableDeque();
+    if (deque.IsIdle() != is_idle && deque.SetIdle(is_idle)) {
+      idle_consumers_.fetch_add(is_idle ? 1 : -1);
+    }
+  }
+
+  void WakeUpIdleConsumer() {
+    if (idle_consumers_.load() <= 0) [[likely]] {
+      return;
+    }
+    EpochReadGuard epoch_guard;
+    auto snapshot = consumers_.load();
+    for (std::size_t i = 0; i < snapshot->ids.size(); i++) {
+      auto queue_ptr = snapshot->queues[i].get();
+      if (!queue_ptr->IsWorkStealing() ||
+          !queue_ptr->GetStealableDeque().IsIdle() || !queue_ptr->Enter()) {
+        continue;
+      }
+      bool is_woken = queue_ptr->GetStealableDeque().SetIdle(false);
+      if (is_woken) {
+        idle_consumers_.fetch_add(-1);
+        WriteEventFd(snapshot->ids[i]);
+      }
+      queue_ptr->Leave();
+      if (is_woken) {
+        return;
+      }
+    }
+  }
+
+  DispatchStats GetStats() {
+    DispatchStats stats{};
+    {
+      std::lock_guard guard(registration_lock_);
+      stats = deregistered_stats_;
+    }
+    EpochReadGuard epoch_guard;
+    auto snapshot = consumers_.load();
+    for (auto& queue : snapshot->queues) {
+      queue->AddStatsTo(stats);
+    }
+    return stats;
   }
 
  private:
-  void NotifyEventLoop(EventLoopWakeUpHandle id, std::uint64_t count) {
-    int wrote = write(id, &count, sizeof(count));
-    if (wrote < 0) {
-      throw arc::exception::IOException("Notify EventLoop Error");
+  std::size_t GetNextConsumer(const ConsumerSnapshot& snapshot,
+                              DispatchPolicy policy, int numa_node) {
+    // choose among the consumers on the node if there are any
+    const std::vector<std::size_t>* local_consumers = nullptr;
+    if (numa_node >= 0 &&
+        static_cast<std::size_t>(numa_node) <
+            snapshot.numa_node_consumers.size() &&
+        !snapshot.numa_node_consumers[numa_node].empty()) {
+      local_consumers = &snapshot.numa_node_consumers[numa_node];
+    }
+    std::size_t size =
+        local_consumers ? local_consumers->size() : snapshot.ids.size();
+    auto index_at = [local_consumers](std::size_t i) {
+      return local_consumers ? (*local_consumers)[i] : i;
+    };
+
+    switch (policy) {
+      case DispatchPolicy::LEAST_QUEUED: {
+        // start from the round robin position so that ties are spread
+        std::size_t start =
+            next_consumer_.fetch_add(1, std::memory_order::relaxed);
+        std::size_t least_index = index_at(start % size);
+        int least_count = snapshot.queues[least_index]->GetQueuedCount();
+        for (std::size_t i = 1; i < size && least_count > 0; i++) {
+          std::size_t index = index_at((start + i) % size);
+          int count = snapshot.queues[index]->GetQueuedCount();
+          if (count < least_count) {
+            least_index = index;
+            least_count = count;
+          }
+        }
+        return least_index;
+      }
+      case DispatchPolicy::POWER_OF_TWO_CHOICES: {
+        if (size == 1) {
+          return index_at(0);
+        }
+        std::size_t first_pos = NextRandom() % size;
+        std::size_t second_pos =
+            (first_pos + 1 + NextRandom() % (size - 1)) % size;
+        std::size_t first = index_at(first_pos);
+        std::size_t second = index_at(second_pos);
+        auto& first_queue = snapshot.queues[first];
+        auto& second_queue = snapshot.queues[second];
+        std::int64_t now =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch())
+                .count();
+        auto first_load = first_queue->GetLoad(now);
+        auto second_load = second_queue->GetLoad(now);
+        if (first_load == second_load) {
+          return first_queue->GetQueuedCount() <=
+                         second_queue->GetQueuedCount()
+                     ? first
+                     : second;
+        }
+        return first_load < second_load ? first : second;
+      }
+      case DispatchPolicy::ROUND_ROBIN:
+      default:
+        return index_at(
+            next_consumer_.fetch_add(1, std::memory_order::relaxed) % size);
     }
   }
 
-  template <typename It>
-  bool EnqueueAllToAnyNoLock(It it, int count) {
-    EventLoopWakeUpHandle next_consumer_id = GetNextConsumer();
-    auto queue_ptr = GetCoroutineQueue(next_consumer_id);
-    bool ret = queue_ptr->EnqueueBulk(it, count);
-    if (ret) {
-      NotifyEventLoop(next_consumer_id, count);
+  static void IndexNumaNodes(ConsumerSnapshot& snapshot) {
+    snapshot.numa_node_consumers.clear();
+    for (std::size_t i = 0; i < snapshot.numa_nodes.size(); i++) {
+      int numa_node = snapshot.numa_nodes[i];
+      if (numa_node < 0) {
+        continue;
+      }
+      if (snapshot.numa_node_consumers.size() <=
+          static_cast<std::size_t>(numa_node)) {
+        snapshot.numa_node_consumers.resize(numa_node + 1);
+      }
+      snapshot.numa_node_consumers[numa_node].push_back(i);
     }
-    return ret;
   }
 
-  EventLoopWakeUpHandle GetNextConsumer() {
-    if (consumer_ids_.empty()) {
-      throw arc::exception::detail::ExceptionBase("No consumer available");
+  // rendezvous hashing, the consumer with the highest weight for the key
+  static std::size_t GetConsumerIndexByKey(const ConsumerSnapshot& snapshot,
+                                           std::uint64_t key) {
+    std::size_t best_index = 0;
+    std::uint64_t best_weight = 0;
+    for (std::size_t i = 0; i < snapshot.ids.size(); i++) {
+      std::uint64_t weight =
+          Mix(key ^ Mix(static_cast<std::uint64_t>(snapshot.ids[i])));
+      if (i == 0 || weight > best_weight) {
+        best_index = i;
+        best_weight = weight;
+      }
+    }
+    return best_index;
+  }
+
+  // the splitmix64 finalizer
+  static std::uint64_t Mix(std::uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+  }
+
+  static std::uint32_t NextRandom() {
+    thread_local std::uint32_t state =
+        std::hash<std::thread::id>{}(std::this_thread::get_id()) | 1U;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+  }
+
+  // a consumer drains its queue before going to sleep again, so that only
+  // sleeping consumers need to be notified
+  void NotifyEventLoop(CoroutineQueue* queue_ptr, EventLoopWakeUpHandle id,
+                       int count) {
+    if (queue_ptr->RecordEnqueue(count)) {
+      WriteEventFd(id);
     }
-    EventLoopWakeUpHandle next_consumer_id = *consumer_id_itr_;
-    consumer_id_itr_++;
-    if (consumer_id_itr_ == consumer_ids_.end()) {
-      consumer_id_itr_ = consumer_ids_.begin();
+  }
+
+  void WriteEventFd(EventLoopWakeUpHandle id) {
+    std::uint64_t count = 1;
+    int wrote = write(id, &count, sizeof(count));
+    if (wrote < 0) {
+      throw arc::exception::IOException("Notify EventLoop Error");
     }
-    return next_consumer_id;
   }
 
-  CoroutineQueue* GetCoroutineQueue(EventLoopWakeUpHandle id) {
+  CoroutineQueue* FindCoroutineQueue(const ConsumerSnapshot& snapshot,
+                                     EventLoopWakeUpHandle id) {
+    if (id < 0) [[unlikely]] {
+      return nullptr;
+    }
     if (id < kMaxInVecQueueCount_) [[likely]] {
-      assert(queues_[id]);
-      return queues_[id];
+      return snapshot.in_vec_queues[id];
+    }
+    auto itr = snapshot.extra_queues.find(id);
+    return itr == snapshot.extra_queues.end() ? nullptr : itr->second;
+  }
+
+  CoroutineQueue* GetCoroutineQueue(const ConsumerSnapshot& snapshot,
+                                    EventLoopWakeUpHandle id) {
+    auto queue_ptr = FindCoroutineQueue(snapshot, id);
+    if (queue_ptr == nullptr) [[unlikely]] {
+      throw arc::exception::detail::ExceptionBase(
+          "Consumer id " + std::to_string(id) + " is not registered.");
     }
-    assert(extra_queues_[id]);
-    return extra_queues_[id];
+    return queue_ptr;
   }
 
-  std::mutex global_addition_lock_;
+  // only serializes Register, DeRegister and taking stats, dispatching never
+  // takes it
+  std::mutex registration_lock_;
+  DispatchStats deregistered_stats_{};
 
   const int kMaxAllowedProducerCount_;
 
   constexpr static int kCoroutineQueueDefaultSize_ = 1024;
   constexpr static int kMaxInVecQueueCount_ = 512;
-  std::vector<CoroutineQueue*> queues_;
-  std::unordered_map<EventLoopWakeUpHandle, CoroutineQueue*> extra_queues_;
+  // replaced by Register and DeRegister under the registration lock, old
+  // snapshots are freed after an epoch synchronization
+  std::atomic<const ConsumerSnapshot*> consumers_{nullptr};
+  std::atomic<std::size_t> next_consumer_{0};
 
-  std::vector<EventLoopWakeUpHandle> consumer_ids_;
-  std::vector<EventLoopWakeUpHandle>::iterator consumer_id_itr_;
+  // coroutines in all stealable deques
+  std::atomic<int> stealable_items_{0};
+  std::atomic<int> idle_consumers_{0};
 };
 
 }  // namespace coro
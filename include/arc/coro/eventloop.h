@@ -34,12 +34,15 @@
 #include <arc/coro/events/io_event.h>
 #include <arc/coro/events/time_event.h>
 #include <arc/coro/events/user_event.h>
+#include <arc/coro/utils/event_allocator.h>
+#include <arc/coro/utils/loop_profile.h>
+#include <arc/coro/utils/ring_buffer.h>
 #include <arc/io/io_base.h>
 #include <arc/utils/bits.h>
 #include <assert.h>
 
 #ifdef __linux__
-#include <arc/coro/poller/epoll.h>
+#include <arc/coro/poller/poller.h>
 #endif
 
 #ifdef __clang__
@@ -50,7 +53,8 @@ using experimental::coroutine_handle;
 #else
 #include <coroutine>
 #endif
-#include <list>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace arc {
@@ -64,6 +68,46 @@ enum class EventLoopType {
   CONSUMER = 2U,
 };
 
+struct EventLoopOptions {
+  PollerType poller_type{PollerType::EPOLL};
+  // register each fd only once with EPOLLET, only used by the epoll poller
+  bool epoll_edge_triggered{false};
+  // keep time events in microseconds instead of milliseconds
+  bool high_resolution_timer{false};
+  // try socket io before waiting for its readiness
+  bool speculative_io{false};
+  // the longest time in microseconds to poll without blocking before each
+  // wait, the actual time adapts to how soon events come, 0 disables it
+  std::int64_t busy_poll_us{0};
+  // keep coroutines dispatched to any consumer in a local deque, resume a few
+  // of them per iteration and steal from busy consumers before blocking, only
+  // used by consumers and only steals from consumers with this option on
+  bool work_stealing{false};
+  // how coroutines dispatched by this producer to any consumer are placed
+  DispatchPolicy dispatch_policy{DispatchPolicy::ROUND_ROBIN};
+  // pin the loop thread to the cpu before the loop allocates anything, -1
+  // leaves it floating
+  int cpu_affinity{-1};
+  // memory allocated by the loop thread prefers the numa node it runs on
+  bool numa_local_memory{false};
+  // dispatch only to consumers on the same numa node as this producer when
+  // there are any
+  bool prefer_local_numa_consumers{false};
+  // record timing histograms of each iteration, which costs a few clock reads
+  // per iteration, event counters are always kept
+  bool profile_timing{false};
+};
+
+struct SpeculativeIOStats {
+  std::uint64_t attempts{0};
+  // ios completed without suspending
+  std::uint64_t inline_completions{0};
+
+  inline double HitRate() const {
+    return attempts == 0 ? 0 : static_cast<double>(inline_completions) / attempts;
+  }
+};
+
 template <arc::concepts::CopyableMoveableOrVoid T>
 class [[nodiscard]] Task;
 
@@ -76,8 +120,33 @@ class EventLoop {
   void Do();
 
   static EventLoop& GetLocalInstance();
+  // tells the event loop of this thread, if any, that fd is a new file
+  static void ResetLocalIOInterest(int fd);
+
+  // options only take effect if they are set before the event loop of the
+  // current thread is created
+  static void SetLocalOptions(const EventLoopOptions& options);
+  inline const EventLoopOptions& GetOptions() const { return options_; }
+
+  inline const EventAllocatorStats& GetEventAllocatorStats() const {
+    return event_allocator_.GetStats();
+  }
+
+  inline void RecordSpeculativeIO(bool is_done) {
+    speculative_io_stats_.attempts++;
+    speculative_io_stats_.inline_completions += is_done;
+  }
+  inline const SpeculativeIOStats& GetSpeculativeIOStats() const {
+    return speculative_io_stats_;
+  }
+
+  // a snapshot of the counters and histograms, safe to be taken from any
+  // thread while the loop is alive
+  EventLoopProfile GetProfile() const;
 
   inline EventLoopID GetEventLoopID() { return id_; }
+  // the node the loop was created on, which stays true if it is pinned
+  inline int GetNumaNode() const { return numa_node_; }
 
   inline void AddIOEvent(coro::IOEvent* event) { poller_->AddIOEvent(event); }
 
@@ -99,8 +168,14 @@ class EventLoop {
     return poller_->GetEventHandle();
   }
 
-  inline bool TriggerUserEvent(EventID event_id) {
-    return poller_->TriggerUserEvent(event_id);
+  // a user event of the loop running on this thread is resumed from the ready
+  // queue instead of waking up the poller
+  bool TriggerUserEvent(EventID event_id);
+
+  // resumes the coroutine at the end of this iteration, only called from the
+  // loop thread
+  inline void AddReadyCoroutine(std::coroutine_handle<> handle) {
+    ready_coroutines_.PushBack({handle, nullptr});
   }
 
   inline void TriggerBoundEvent(int bind_event_id, coro::BoundEvent* event) {
@@ -112,6 +187,10 @@ class EventLoop {
 
   void Dispatch(Task<void>&& task);
   void DispatchTo(Task<void>&& task, EventLoopWakeUpHandle event_loop_id);
+  // tasks with the same key start in dispatch order on the same consumer, so
+  // state owned by the key needs no lock between suspension points, keys move
+  // only when consumers register or deregister
+  void DispatchByKey(std::uint64_t key, Task<void>&& task);
 
   void ResigerConsumer();
   void DeResigerConsumer();
@@ -120,25 +199,62 @@ class EventLoop {
 
  private:
   EventLoop();
+  int WaitEvents();
+  int PollEvents(std::int64_t timeout);
+  bool HasCoroutinesToConsume() const;
+  bool StealCoroutines();
+  void ResumeReadyCoroutines();
   void Trim();
 
+  inline detail::ProfileHistogram* Profiled(
+      detail::ProfileHistogram& histogram) {
+    return options_.profile_timing ? &histogram : nullptr;
+  }
+
+  inline int GetDispatchNumaNode() const {
+    return options_.prefer_local_numa_consumers ? numa_node_ : -1;
+  }
+
+  EventLoopOptions options_{};
+  EventAllocator event_allocator_{};
+  SpeculativeIOStats speculative_io_stats_{};
+  // busy poll related, in nanoseconds
+  std::int64_t busy_poll_max_budget_{0};
+  std::int64_t busy_poll_budget_{0};
+  // exponentially smoothed busy time per iteration, in nanoseconds
+  std::int64_t loop_lag_{0};
+  const static int kLoopLagSmoothingFactor_ = 8;
+  detail::EventLoopTimings timings_{};
   Poller* poller_{nullptr};
 
   EventLoopID id_{-1};
+  int numa_node_{-1};
 
   bool is_running_{false};
 
   const static int kMaxEventsSizePerWait_ = Poller::kMaxEventsSizePerWait;
   const static int kMaxConsumableCoroutineNum_ = 4;
+  constexpr static int kMaxDequeuedCoroutineNum_ = 128;
 
   // poller related
   coro::EventBase* todo_events_[2 * kMaxEventsSizePerWait_] = {nullptr};
 
   std::vector<std::coroutine_handle<>> to_clean_up_handles_{};
 
+  // the event is set if the coroutine waited on one, which is deleted once
+  // the coroutine is resumed
+  struct ReadyCoroutine {
+    std::coroutine_handle<> handle;
+    coro::EventBase* event;
+  };
+  RingBuffer<ReadyCoroutine> ready_coroutines_{};
+
   // dispatched events
-  std::list<std::coroutine_handle<>> to_randomly_dispatched_coroutines_{};
-  std::unordered_map<EventLoopWakeUpHandle, std::list<std::coroutine_handle<>>>
+  RingBuffer<std::coroutine_handle<>> to_randomly_dispatched_coroutines_{};
+  RingBuffer<std::pair<std::uint64_t, std::coroutine_handle<>>>
+      to_key_dispatched_coroutines_{};
+  // buffers of consumers are kept after they are drained
+  std::unordered_map<EventLoopWakeUpHandle, RingBuffer<std::coroutine_handle<>>>
       to_dispatched_coroutines_with_dests_{};
   int to_dispatched_coroutines_count_{0};
   EventLoopWakeUpHandle register_id_{-1};
@@ -147,6 +263,7 @@ class EventLoop {
   CoroutineQueue* dispatcher_queue_{nullptr};
   void ConsumeCoroutine();
   void ProduceCoroutine();
+  static void ResumeSpaceWaiters(const std::vector<SpaceWaiter>& waiters);
 };
 
 }  // namespace coro
@@ -29,6 +29,7 @@
 #ifndef LIBARC__CORO__EVENTS__EVENT_BASE_H
 #define LIBARC__CORO__EVENTS__EVENT_BASE_H
 
+#include <arc/coro/utils/event_allocator.h>
 #include <unistd.h>
 #include <cassert>
 #ifdef __clang__
@@ -50,6 +51,24 @@ class EventBase {
   EventBase(std::coroutine_handle<void> handle) : handle_(handle) {}
   virtual ~EventBase() {}
 
+  // events are recycled by the allocator of the current event loop
+  static inline void* operator new(std::size_t size) {
+    auto allocator = EventAllocator::GetLocalInstance();
+    if (allocator != nullptr) [[likely]] {
+      return allocator->Allocate(size);
+    }
+    return ::operator new(EventAllocator::RoundUp(size));
+  }
+
+  static inline void operator delete(void* ptr, std::size_t size) {
+    auto allocator = EventAllocator::GetLocalInstance();
+    if (allocator != nullptr) [[likely]] {
+      allocator->Deallocate(ptr, size);
+      return;
+    }
+    ::operator delete(ptr);
+  }
+
   virtual void Resume() {
     assert(!handle_.done());
     handle_.resume();
@@ -40,6 +40,10 @@ namespace coro {
 
 class IOEvent : public EventBase {
  public:
+  // Performs the io of the waiting coroutine without resuming it. Returns
+  // false if the io would block.
+  using TryIOFunctor = bool (*)(void*);
+
   IOEvent(int fd, io::IOType io_type, std::coroutine_handle<void> handle)
       : EventBase(handle), fd_(fd), io_type_(io_type) {}
 
@@ -48,9 +52,30 @@ class IOEvent : public EventBase {
   inline int GetFd() const noexcept { return fd_; }
   inline io::IOType GetIOType() const noexcept { return io_type_; }
 
+  inline void SetTryIO(TryIOFunctor try_io, void* try_io_context) noexcept {
+    try_io_ = try_io;
+    try_io_context_ = try_io_context;
+  }
+  inline bool HasTryIO() const noexcept { return try_io_ != nullptr; }
+  inline bool TryIO() { return try_io_(try_io_context_); }
+
+  // the resumed coroutine keeps doing the io until it would block
+  inline void SetDrainsFd() noexcept { is_draining_fd_ = true; }
+  inline bool IsDrainingFd() const noexcept { return is_draining_fd_; }
+
+  friend class Poller;
+
  protected:
   int fd_{-1};
   io::IOType io_type_{};
+  TryIOFunctor try_io_{nullptr};
+  void* try_io_context_{nullptr};
+  bool is_draining_fd_{false};
+
+ private:
+  // intrusive links of the waiting list of the fd in the poller
+  IOEvent* prev_io_event_{nullptr};
+  IOEvent* next_io_event_{nullptr};
 };
 
 }  // namespace coro
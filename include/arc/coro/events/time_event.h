@@ -35,6 +35,24 @@
 namespace arc {
 namespace coro {
 
+namespace detail {
+
+// wakeup times of time events are nanoseconds of std::chrono::steady_clock
+inline std::int64_t GetCurrentTime() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+inline std::int64_t ToWakeupTime(
+    const std::chrono::steady_clock::duration& sleep_time) {
+  return GetCurrentTime() +
+         std::chrono::duration_cast<std::chrono::nanoseconds>(sleep_time)
+             .count();
+}
+
+}  // namespace detail
+
 class TimeEvent : virtual public EventBase {
  public:
   TimeEvent(std::int64_t wakeup_time, std::coroutine_handle<void> handle)
@@ -44,16 +62,21 @@ class TimeEvent : virtual public EventBase {
 
   const inline std::int64_t GetWakeupTime() const { return wakeup_time_; }
 
-  const inline bool IsValid() const { return is_valid_; }
-  inline void SetValidity(bool is_valid) { is_valid_ = is_valid; }
-
   const inline bool IsTrigger() const { return is_trigger_; }
 
   friend class TimeEventComparator;
+  friend class TimingWheel;
+
  protected:
   std::int64_t wakeup_time_ = 0;
-  bool is_valid_{true};
   bool is_trigger_{false};
+
+ private:
+  // intrusive links of the timing wheel
+  TimeEvent* wheel_prev_{nullptr};
+  TimeEvent* wheel_next_{nullptr};
+  std::int64_t wheel_tick_{0};
+  int wheel_slot_{-1};
 };
 
 class TimeEventComparator {
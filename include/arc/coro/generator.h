@@ -0,0 +1,326 @@
+/*
+ * File: generator.h
+ * Project: libarc
+ * File Created: Sunday, 18th October 2026 3:47:19 am
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef LIBARC__CORO__GENERATOR_H
+#define LIBARC__CORO__GENERATOR_H
+
+#include <arc/coro/utils/frame_pool.h>
+
+#ifdef __clang__
+#include <experimental/coroutine>
+namespace std {
+using experimental::coroutine_handle;
+using experimental::suspend_always;
+}  // namespace std
+#else
+#include <coroutine>
+#endif
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace arc {
+namespace coro {
+
+// A lazy stream of values produced by co_yield, iterated with a range-based
+// for loop. The frame is allocated once for the whole stream and each value
+// is handed out by reference without being copied.
+template <typename T>
+class [[nodiscard]] Generator {
+ public:
+  using ValueType = std::remove_reference_t<T>;
+
+  class promise_type {
+   public:
+    static void* operator new(std::size_t size) {
+      return FramePool::Allocate(size);
+    }
+    static void operator delete(void* ptr) noexcept {
+      FramePool::Deallocate(ptr);
+    }
+
+    Generator get_return_object() {
+      return Generator(
+          std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    std::suspend_always final_suspend() noexcept { return {}; }
+
+    std::suspend_always yield_value(ValueType& value) noexcept {
+      value_ = std::addressof(value);
+      return {};
+    }
+    std::suspend_always yield_value(ValueType&& value) noexcept {
+      value_ = std::addressof(value);
+      return {};
+    }
+
+    void return_void() {}
+    void unhandled_exception() { exception_ = std::current_exception(); }
+
+    // no co_await inside a synchronous generator
+    template <typename U>
+    std::suspend_never await_transform(U&& value) = delete;
+
+    inline ValueType& GetValue() const { return *value_; }
+
+    void RethrowIfFailed() {
+      if (exception_) {
+        std::rethrow_exception(exception_);
+      }
+    }
+
+   private:
+    ValueType* value_{nullptr};
+    std::exception_ptr exception_{nullptr};
+  };
+
+  class Iterator {
+   public:
+    using iterator_category = std::input_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    using value_type = std::remove_cv_t<ValueType>;
+    using reference = ValueType&;
+    using pointer = ValueType*;
+
+    Iterator() = default;
+    explicit Iterator(std::coroutine_handle<promise_type> coroutine)
+        : coroutine_(coroutine) {}
+
+    Iterator& operator++() {
+      coroutine_.resume();
+      if (coroutine_.done()) {
+        coroutine_.promise().RethrowIfFailed();
+      }
+      return *this;
+    }
+    void operator++(int) { ++*this; }
+
+    reference operator*() const { return coroutine_.promise().GetValue(); }
+    pointer operator->() const { return std::addressof(operator*()); }
+
+    bool operator==(std::default_sentinel_t) const {
+      return !coroutine_ || coroutine_.done();
+    }
+
+   private:
+    std::coroutine_handle<promise_type> coroutine_{nullptr};
+  };
+
+  Generator(Generator&& other)
+      : coroutine_(std::exchange(other.coroutine_, nullptr)) {}
+  Generator(const Generator&) = delete;
+  Generator& operator=(Generator&& other) {
+    if (std::addressof(other) != this) {
+      if (coroutine_) {
+        coroutine_.destroy();
+      }
+      coroutine_ = std::exchange(other.coroutine_, nullptr);
+    }
+    return *this;
+  }
+  Generator& operator=(const Generator&) = delete;
+
+  ~Generator() {
+    if (coroutine_) {
+      coroutine_.destroy();
+    }
+  }
+
+  // runs to the first value, can only be called once
+  Iterator begin() {
+    Iterator itr(coroutine_);
+    return ++itr;
+  }
+  std::default_sentinel_t end() { return {}; }
+
+ private:
+  explicit Generator(std::coroutine_handle<promise_type> coroutine)
+      : coroutine_(coroutine) {}
+
+  std::coroutine_handle<promise_type> coroutine_{nullptr};
+};
+
+// A lazy stream of values which may co_await between its co_yields. C++20
+// has no for co_await, so it is iterated with awaitable begin and increment:
+//
+//   for (auto itr = co_await stream.begin(); itr != stream.end();
+//        co_await ++itr) {
+//     Use(*itr);
+//   }
+//
+// Control moves between the consumer and the stream by symmetric transfer,
+// so each value costs no allocation and no trip through the event loop.
+template <typename T>
+class [[nodiscard]] AsyncGenerator {
+ public:
+  using ValueType = std::remove_reference_t<T>;
+
+  class promise_type {
+   public:
+    static void* operator new(std::size_t size) {
+      return FramePool::Allocate(size);
+    }
+    static void operator delete(void* ptr) noexcept {
+      FramePool::Deallocate(ptr);
+    }
+
+    AsyncGenerator get_return_object() {
+      return AsyncGenerator(
+          std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    auto final_suspend() noexcept { return YieldAwaiter{}; }
+
+    auto yield_value(ValueType& value) noexcept {
+      value_ = std::addressof(value);
+      return YieldAwaiter{};
+    }
+    auto yield_value(ValueType&& value) noexcept {
+      value_ = std::addressof(value);
+      return YieldAwaiter{};
+    }
+
+    void return_void() {}
+    void unhandled_exception() { exception_ = std::current_exception(); }
+
+    inline ValueType& GetValue() const { return *value_; }
+    inline void SetConsumer(std::coroutine_handle<> consumer) {
+      consumer_ = consumer;
+    }
+
+    void RethrowIfFailed() {
+      if (exception_) {
+        std::rethrow_exception(exception_);
+      }
+    }
+
+   private:
+    // hands the value or the end of the stream back to the consumer
+    struct YieldAwaiter {
+      bool await_ready() noexcept { return false; }
+      std::coroutine_handle<> await_suspend(
+          std::coroutine_handle<promise_type> handle) noexcept {
+        return handle.promise().consumer_;
+      }
+      void await_resume() noexcept {}
+    };
+
+    ValueType* value_{nullptr};
+    std::exception_ptr exception_{nullptr};
+    std::coroutine_handle<> consumer_{nullptr};
+  };
+
+  class Iterator;
+
+  // runs the stream to its next value or its end
+  class [[nodiscard]] AdvanceAwaiter {
+   public:
+    explicit AdvanceAwaiter(std::coroutine_handle<promise_type> coroutine)
+        : coroutine_(coroutine) {}
+
+    bool await_ready() { return !coroutine_ || coroutine_.done(); }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> consumer) {
+      coroutine_.promise().SetConsumer(consumer);
+      return coroutine_;
+    }
+
+    Iterator await_resume() {
+      if (coroutine_ && coroutine_.done()) {
+        coroutine_.promise().RethrowIfFailed();
+      }
+      return Iterator(coroutine_);
+    }
+
+   private:
+    std::coroutine_handle<promise_type> coroutine_;
+  };
+
+  class Iterator {
+   public:
+    using iterator_category = std::input_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    using value_type = std::remove_cv_t<ValueType>;
+    using reference = ValueType&;
+    using pointer = ValueType*;
+
+    explicit Iterator(std::coroutine_handle<promise_type> coroutine)
+        : coroutine_(coroutine) {}
+
+    AdvanceAwaiter operator++() { return AdvanceAwaiter(coroutine_); }
+
+    reference operator*() const { return coroutine_.promise().GetValue(); }
+    pointer operator->() const { return std::addressof(operator*()); }
+
+    bool operator==(std::default_sentinel_t) const {
+      return !coroutine_ || coroutine_.done();
+    }
+
+   private:
+    std::coroutine_handle<promise_type> coroutine_{nullptr};
+  };
+
+  AsyncGenerator(AsyncGenerator&& other)
+      : coroutine_(std::exchange(other.coroutine_, nullptr)) {}
+  AsyncGenerator(const AsyncGenerator&) = delete;
+  AsyncGenerator& operator=(AsyncGenerator&& other) {
+    if (std::addressof(other) != this) {
+      if (coroutine_) {
+        coroutine_.destroy();
+      }
+      coroutine_ = std::exchange(other.coroutine_, nullptr);
+    }
+    return *this;
+  }
+  AsyncGenerator& operator=(const AsyncGenerator&) = delete;
+
+  // must not be destroyed while it is suspended in a co_await
+  ~AsyncGenerator() {
+    if (coroutine_) {
+      coroutine_.destroy();
+    }
+  }
+
+  // runs to the first value, can only be awaited once
+  AdvanceAwaiter begin() { return AdvanceAwaiter(coroutine_); }
+  std::default_sentinel_t end() { return {}; }
+
+ private:
+  explicit AsyncGenerator(std::coroutine_handle<promise_type> coroutine)
+      : coroutine_(coroutine) {}
+
+  std::coroutine_handle<promise_type> coroutine_{nullptr};
+};
+
+}  // namespace coro
+}  // namespace arc
+
+#endif /* LIBARC__CORO__GENERATOR_H */
@@ -31,119 +31,78 @@
 
 #ifdef __linux__
 
-#include <arc/coro/events/cancellation_event.h>
-#include <arc/coro/events/timeout_event.h>
-#include <arc/coro/events/condition_event.h>
-#include <arc/coro/events/io_event.h>
-#include <arc/coro/events/time_event.h>
-#include <arc/io/io_base.h>
+#include <arc/coro/poller/poller.h>
 #include <sys/epoll.h>
 
-#include <atomic>
-#include <deque>
-#include <list>
-#include <mutex>
-#include <queue>
-#include <unordered_map>
-#include <unordered_set>
+#include <cstdint>
 #include <vector>
 
 namespace arc {
 namespace coro {
 
-class Poller : public io::detail::IOBase {
+// In edge-triggered mode every fd is registered once with
+// EPOLLIN | EPOLLOUT | EPOLLET when it is first awaited and stays registered
+// until all of its io events are removed. The readiness of each direction is
+// remembered until an io of that direction would block.
+//
+// With the high resolution timer, waits are done by epoll_pwait2, or by a
+// timerfd registered in the epoll if the kernel does not support it.
+class EpollPoller : public Poller {
  public:
-  Poller();
-  ~Poller();
+  EpollPoller(bool is_high_resolution_timer = false,
+              bool is_edge_triggered = false);
+  ~EpollPoller();
 
-  void AddIOEvent(coro::IOEvent* event);
-  void AddTimeEvent(coro::TimeEvent* event);
-  void AddUserEvent(coro::UserEvent* event);
-  void AddBoundEvent(coro::BoundEvent* event);
+  void TrimIOEvents() override;
+  void ResetIOInterest(int target_fd) override;
 
-  void RemoveAllIOEvents(int target_fd);
-
-  int WaitEvents(coro::EventBase** todo_events);
-
-  void TrimIOEvents();
-  void TrimTimeEvents();
-  void TrimUserEvents();
-
-  inline void SetNextTimeNoWait() { next_wait_timeout_ = 0; }
-
-  inline bool IsPollerDone() {
-    std::lock_guard<std::mutex> guard(poller_lock_);
-    auto ret = (total_io_events_ + time_events_.size() +
-                pending_user_events_.size() + triggered_user_events_.size() +
-                pending_bound_events_.size() +
-                triggered_bound_events_.size() ==
-            0) &&
-           (!is_dispatcher_registered_);
-    return ret;
-  }
-
-  inline int GetEventHandle() const { return user_event_fd_; }
-  bool TriggerUserEvent(EventID event_id);
-  void TriggerBoundEvent(EventID bound_event_id,
-                                coro::BoundEvent* event);
-
-  int Register();
-  void DeRegister();
-
-  const static int kMaxEventsSizePerWait = 1024;
+ protected:
+  int WaitIOEvents(coro::EventBase** todo_events,
+                   bool* is_user_event_triggered) override;
+  void RemoveIOInterest(int target_fd) override;
+  void SetUserEventInterest(bool is_interested) override;
 
  private:
-  const static int kMaxFdInArray_ = 1024;
-
-  int next_wait_timeout_ = -1;
-
-  std::atomic<EventID> max_event_id_{0};
-
-  // io events
-  int total_io_events_{0};
-  std::unordered_set<int> interesting_fds_{};
-  // {fd -> {io_type -> [events]}}
-  std::vector<std::vector<std::deque<coro::IOEvent*>>> io_events_{
-      kMaxFdInArray_,
-      std::vector<std::deque<coro::IOEvent*>>{2, std::deque<coro::IOEvent*>{}}};
-  int io_prev_events_[kMaxFdInArray_] = {0};
-
-  std::unordered_map<int, std::vector<std::deque<coro::IOEvent*>>>
-      extra_io_events_{};
-  std::unordered_map<int, int> extra_io_prev_events_{};
-
-  // time events
-  std::priority_queue<coro::TimeEvent*, std::vector<coro::TimeEvent*>,
-                      coro::TimeEventComparator>
-      time_events_;
-
-  // user events
-  int user_event_fd_{-1};
-  bool is_event_fd_added_{false};
-  std::mutex poller_lock_;
-  std::list<coro::UserEvent*> pending_user_events_;
-  std::list<coro::UserEvent*> triggered_user_events_;
-  std::unordered_map<EventID, coro::UserEvent*> user_events_;
-
-  // cancellation events
-  std::list<coro::BoundEvent*> pending_bound_events_;
-  std::list<coro::BoundEvent*> triggered_bound_events_;
-  std::unordered_map<EventID, std::list<coro::BoundEvent*>::iterator>
-      event_pending_bound_token_map_;
-  EventID self_triggered_event_ids_[kMaxEventsSizePerWait] = {0};
-
-  // coro dispatcher related
-  bool is_dispatcher_registered_{false};
+  // the registered epoll events of each fd
+  std::vector<int> io_prev_events_{};
+
+  // edge-triggered mode related
+  enum EdgeState : std::uint8_t {
+    READ_READY = 1U << 0,
+    WRITE_READY = 1U << 1,
+    READ_REARM = 1U << 2,
+    WRITE_REARM = 1U << 3,
+    REGISTERED = 1U << 4,
+    PENDING = 1U << 5,
+  };
+
+  bool is_edge_triggered_{false};
+  std::vector<std::uint8_t> io_edge_states_{};
+  // fds which are ready and have io events waiting
+  std::vector<int> ready_fds_{};
 
   // epoll related
   epoll_event events_[kMaxEventsSizePerWait];
 
+  // high resolution timer related
+  bool is_pwait2_supported_{true};
+  int timer_fd_{-1};
+
+  int Wait(std::int64_t timeout);
+  int WaitWithTimerFd(const timespec& timeout);
+  bool IsTimerFd(int fd);
+
+  int Control(int op, int fd, epoll_event* event);
+  // Control for io fds which tolerates registrations gone stale
+  int ControlIO(int op, int fd, epoll_event* event);
   int GetExistingIOEvent(int fd);
-  coro::IOEvent* PopIOEvent(int fd, io::IOType event_type);
-  EventBase* PopBoundEvent(coro::BoundEvent* event);
-  void RemoveBoundEvent(int count);
-  void TriggerBoundEventInternal(int bound_event_id,
-                                coro::BoundEvent* event);
+
+  int WaitIOEventsEdgeTriggered(coro::EventBase** todo_events,
+                                bool* is_user_event_triggered);
+  void TrimIOEventsEdgeTriggered();
+  std::uint8_t& GetEdgeState(int fd);
+  int PopReadyIOEvents(int fd, io::IOType event_type,
+                       coro::EventBase** todo_events, int todo_cnt);
 };
 
 }  // namespace coro
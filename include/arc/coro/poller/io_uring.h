@@ -0,0 +1,118 @@
+/*
+ * File: io_uring.h
+ * Project: libarc
+ * File Created: Sunday, 18th October 2026 1:35:07 am
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef LIBARC__CORO__POLLER__IO_URING_H
+#define LIBARC__CORO__POLLER__IO_URING_H
+
+#ifdef __linux__
+
+#include <arc/coro/poller/poller.h>
+#include <linux/io_uring.h>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace arc {
+namespace coro {
+
+// IOUringPoller waits for io readiness with one-shot IORING_OP_POLL_ADD
+// requests. Arming and cancelling polls only queues SQEs, which are submitted
+// together with the wait itself by a single io_uring_enter call.
+class IOUringPoller : public Poller {
+ public:
+  IOUringPoller(bool is_high_resolution_timer = false);
+  ~IOUringPoller();
+
+  void TrimIOEvents() override;
+
+ protected:
+  int WaitIOEvents(coro::EventBase** todo_events,
+                   bool* is_user_event_triggered) override;
+  void RemoveIOInterest(int target_fd) override;
+  void SetUserEventInterest(bool is_interested) override;
+
+ private:
+  const static unsigned kRingEntries_ = 1024;
+
+  enum class PollKind : std::uint64_t {
+    READ = 0U,
+    WRITE = 1U,
+    USER_EVENT = 2U,
+    INTERNAL = 3U,
+  };
+
+  struct PollSlot {
+    bool is_armed{false};
+    std::uint32_t generation{0};
+  };
+
+  // indexed by fd and io type
+  std::vector<std::array<PollSlot, 2>> io_poll_slots_{};
+  PollSlot user_event_poll_slot_{};
+  bool is_user_event_interested_{false};
+
+  // ring related
+  void* sq_ring_ptr_{nullptr};
+  std::size_t sq_ring_size_{0};
+  void* cq_ring_ptr_{nullptr};
+  std::size_t cq_ring_size_{0};
+  io_uring_sqe* sqes_{nullptr};
+  std::size_t sqes_size_{0};
+
+  unsigned* sq_head_{nullptr};
+  unsigned* sq_tail_{nullptr};
+  unsigned sq_ring_mask_{0};
+  unsigned sq_ring_entries_{0};
+  unsigned* cq_head_{nullptr};
+  unsigned* cq_tail_{nullptr};
+  unsigned cq_ring_mask_{0};
+  io_uring_cqe* cqes_{nullptr};
+
+  unsigned to_submit_{0};
+
+  PollSlot& GetPollSlot(int fd, io::IOType event_type);
+  void ArmPoll(int fd, PollKind kind, PollSlot& slot);
+  void CancelPoll(int fd, PollKind kind, PollSlot& slot);
+  io_uring_sqe* GetSQE();
+  void UnmapRings();
+  int Enter(unsigned min_complete, std::int64_t timeout);
+
+  static inline std::uint64_t EncodeUserData(int fd, PollKind kind,
+                                             std::uint32_t generation) {
+    return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(fd)) << 32) |
+           (static_cast<std::uint64_t>(generation & 0x3fffffffU) << 2) |
+           static_cast<std::uint64_t>(kind);
+  }
+};
+
+}  // namespace coro
+}  // namespace arc
+
+#endif  // __linux__
+#endif /* LIBARC__CORO__POLLER__IO_URING_H */
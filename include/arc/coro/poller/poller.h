@@ -0,0 +1,206 @@
+/*
+ * File: poller.h
+ * Project: libarc
+ * File Created: Sunday, 18th October 2026 1:32:07 am
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef LIBARC__CORO__POLLER__POLLER_H
+#define LIBARC__CORO__POLLER__POLLER_H
+
+#ifdef __linux__
+
+#include <arc/coro/events/cancellation_event.h>
+#include <arc/coro/events/condition_event.h>
+#include <arc/coro/events/io_event.h>
+#include <arc/coro/events/time_event.h>
+#include <arc/coro/events/timeout_event.h>
+#include <arc/coro/utils/loop_profile.h>
+#include <arc/coro/utils/timing_wheel.h>
+#include <arc/exception/io.h>
+#include <arc/io/io_base.h>
+
+#include <algorithm>
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace arc {
+namespace coro {
+
+enum class PollerType {
+  EPOLL = 0U,
+  IO_URING = 1U,
+};
+
+// Poller keeps all waiting events of one event loop. The bookkeeping of io,
+// time, user and bound events is shared here, while the way of waiting for
+// the readiness of file descriptors is left to the backends.
+//
+// Time events are kept in nanoseconds. Unless the high resolution timer is
+// enabled, they are rounded to milliseconds as epoll_wait only accepts them.
+class Poller : public io::detail::IOBase {
+ public:
+  Poller(bool is_high_resolution_timer = false);
+  virtual ~Poller();
+
+  void AddIOEvent(coro::IOEvent* event);
+  void AddTimeEvent(coro::TimeEvent* event);
+  void AddUserEvent(coro::UserEvent* event);
+  void AddBoundEvent(coro::BoundEvent* event);
+
+  void RemoveAllIOEvents(int target_fd);
+  // Forgets what is known about target_fd after its number is reused by a new
+  // file, which may have been closed without going through this poller.
+  virtual void ResetIOInterest([[maybe_unused]] int target_fd) {}
+
+  int WaitEvents(coro::EventBase** todo_events);
+
+  virtual void TrimIOEvents() = 0;
+  void TrimTimeEvents();
+  void TrimUserEvents();
+
+  inline void SetNextTimeNoWait() { next_wait_timeout_ = 0; }
+  inline std::int64_t GetNextWaitTimeout() const { return next_wait_timeout_; }
+  inline void SetNextWaitTimeout(std::int64_t timeout) {
+    next_wait_timeout_ = timeout;
+  }
+
+  inline bool IsPollerDone() {
+    std::lock_guard<std::mutex> guard(poller_lock_);
+    auto ret = (total_io_events_ + time_events_.Size() +
+                    pending_user_events_.size() +
+                    triggered_user_events_.size() +
+                    pending_bound_events_.size() +
+                    triggered_bound_events_.size() ==
+                0) &&
+               (!is_dispatcher_registered_);
+    return ret;
+  }
+
+  inline int GetEventHandle() const { return user_event_fd_; }
+  bool TriggerUserEvent(EventID event_id);
+  // takes a pending user event out without waking up the poller, the events
+  // bound to it are dropped, returns nullptr if it is not pending
+  coro::UserEvent* PopUserEvent(EventID event_id);
+  void TriggerBoundEvent(EventID bound_event_id, coro::BoundEvent* event);
+
+  int Register();
+  void DeRegister();
+
+  inline const detail::PollerCounters& GetCounters() const { return counters_; }
+
+  const static int kMaxEventsSizePerWait = 1024;
+
+ protected:
+  constexpr static std::int64_t kLowResolutionTick_ = 1000000;
+  constexpr static std::int64_t kHighResolutionTick_ = 1000;
+
+  const bool is_high_resolution_timer_{false};
+  // in nanoseconds, -1 means waiting infinitely
+  std::int64_t next_wait_timeout_ = -1;
+
+  std::atomic<EventID> max_event_id_{0};
+
+  detail::PollerCounters counters_{};
+
+  // io events
+  int total_io_events_{0};
+  std::unordered_set<int> interesting_fds_{};
+
+  struct IOWaiterList {
+    coro::IOEvent* head{nullptr};
+    coro::IOEvent* tail{nullptr};
+  };
+  struct IOSlot {
+    // indexed by io type
+    IOWaiterList waiters[2];
+  };
+  std::vector<IOSlot> io_slots_{};
+
+  // time events
+  coro::TimingWheel time_events_;
+
+  // user events
+  int user_event_fd_{-1};
+  std::mutex poller_lock_;
+  std::list<coro::UserEvent*> pending_user_events_;
+  std::list<coro::UserEvent*> triggered_user_events_;
+  std::unordered_map<EventID, coro::UserEvent*> user_events_;
+
+  // cancellation events
+  std::list<coro::BoundEvent*> pending_bound_events_;
+  std::list<coro::BoundEvent*> triggered_bound_events_;
+  std::unordered_map<EventID, std::list<coro::BoundEvent*>::iterator>
+      event_pending_bound_token_map_;
+  EventID self_triggered_event_ids_[kMaxEventsSizePerWait] = {0};
+
+  // coro dispatcher related
+  bool is_dispatcher_registered_{false};
+
+  // Waits for the readiness of io events and the user event fd. Ready io
+  // events are popped into todo_events and their count is returned.
+  virtual int WaitIOEvents(coro::EventBase** todo_events,
+                           bool* is_user_event_triggered) = 0;
+  // Stops watching target_fd after all of its io events are removed.
+  virtual void RemoveIOInterest(int target_fd) = 0;
+  virtual void SetUserEventInterest(bool is_interested) = 0;
+
+  bool HasIOEvent(int fd, io::IOType event_type);
+  coro::IOEvent* FrontIOEvent(int fd, io::IOType event_type);
+  coro::IOEvent* PopIOEvent(int fd, io::IOType event_type);
+
+  // Returns the entry of fd in a table indexed by fds, the table grows on
+  // demand so that every fd is looked up in O(1).
+  template <typename T>
+  static inline T& GetFdSlot(std::vector<T>& table, int fd) {
+    if (static_cast<std::size_t>(fd) >= table.size()) [[unlikely]] {
+      if (fd < 0) {
+        throw arc::exception::IOException("Invalid FD: " + std::to_string(fd));
+      }
+      table.resize(std::max(static_cast<std::size_t>(fd) + 1,
+                            table.size() * 2));
+    }
+    return table[fd];
+  }
+
+ private:
+  bool is_user_event_interested_{false};
+
+  static void LinkIOEvent(IOWaiterList& waiters, coro::IOEvent* event);
+  static void UnlinkIOEvent(IOWaiterList& waiters, coro::IOEvent* event);
+
+  EventBase* PopBoundEvent(coro::BoundEvent* event);
+  void RemoveBoundEvent(int count);
+  void RemoveBoundEventOf(EventID event_id);
+};
+
+}  // namespace coro
+}  // namespace arc
+
+#endif  // __linux__
+#endif /* LIBARC__CORO__POLLER__POLLER_H */
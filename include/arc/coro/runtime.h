@@ -0,0 +1,194 @@
+/*
+ * File: runtime.h
+ * Project: libarc
+ * File Created: Sunday, 18th October 2026 2:58:00 am
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef LIBARC__CORO__RUNTIME_H
+#define LIBARC__CORO__RUNTIME_H
+
+#include <arc/coro/eventloop.h>
+#include <arc/coro/task.h>
+#include <arc/coro/utils/cancellation_token.h>
+#include <arc/exception/base.h>
+#include <arc/io/socket.h>
+#include <arc/net/address.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace arc {
+namespace coro {
+
+struct RuntimeOptions {
+  // 0 means one thread per hardware thread
+  int thread_count{0};
+  // pins loop i to the i-th cpu the process is allowed to run on, modulo
+  // their count, which also keeps the memory of a loop on its numa node with
+  // event_loop_options.numa_local_memory
+  bool pin_threads{false};
+  EventLoopOptions event_loop_options{};
+};
+
+// Runs one consumer event loop per thread. Loops share nothing but the
+// dispatcher, tasks stay on the loop they are spawned to.
+class Runtime {
+ public:
+  explicit Runtime(const RuntimeOptions& options = RuntimeOptions{});
+  ~Runtime();
+
+  Runtime(const Runtime&) = delete;
+  Runtime& operator=(const Runtime&) = delete;
+
+  inline int GetThreadCount() const { return handles_.size(); }
+  // the wake up handle of the loop with the index, for ResumeOn
+  inline EventLoopWakeUpHandle GetEventHandle(int index) const {
+    return handles_[index];
+  }
+
+  // runs the task on one of the loops and blocks until the runtime is shut
+  // down, must not be called from a loop of this runtime
+  void Run(Task<void>&& task);
+
+  // runs the task on one of the loops, can be called from any thread
+  void Spawn(Task<void>&& task);
+  // runs the task created for each loop index on that loop
+  void SpawnOnEachLoop(const std::function<Task<void>(int)>& task_factory);
+
+  // stops all loops after their current iteration, coroutines still waiting
+  // are abandoned except for the acceptors of Serve, which close their
+  // listeners first, can be called from any thread including the loops
+  void Shutdown();
+  // waits for all loop threads to exit after Shutdown
+  void Join();
+
+  inline bool IsShutdown() const {
+    return is_shutdown_.load(std::memory_order::acquire);
+  }
+
+  // every loop accepts on its own acceptor bound to the address with
+  // SO_REUSEPORT, so that the kernel spreads connections over the loops
+  // without any cross-thread handoff. With cpu steering, a classic BPF
+  // program maps the cpu receiving the connection to the loop pinned to it,
+  // which keeps a connection on the cpu handling its packets, so it requires
+  // pin_threads. Connections received on other cpus are hashed by the kernel
+  // as usual. Returns the bound
+  // address, port 0 picks one port for all loops. Must not be called from a
+  // loop of this runtime.
+  template <net::Domain AF, typename Handler>
+  net::Address<AF> Serve(const net::Address<AF>& addr, Handler handler,
+                         bool is_cpu_steering = false) {
+    if (is_cpu_steering && !options_.pin_threads) {
+      throw arc::exception::detail::ExceptionBase(
+          "Cpu steering requires the loops to be pinned");
+    }
+    net::Address<AF> bound_addr = addr;
+    for (int i = 0; i < GetThreadCount(); i++) {
+      // bind one by one so that the reuseport group is in the loop order
+      std::promise<net::Address<AF>> listened;
+      auto future = listened.get_future();
+      SpawnTo(i, Accept<AF, Handler>(i, bound_addr, handler, is_cpu_steering,
+                                     std::move(listened)));
+      bound_addr = future.get();
+    }
+    return bound_addr;
+  }
+
+ private:
+  void LoopMain(int index);
+  void SpawnTo(int index, Task<void>&& task);
+  bool IsLoopThread() const;
+  void AttachCpuSteeringProgram(int fd) const;
+
+  template <net::Domain AF, typename Handler>
+  Task<void> Accept(int index, net::Address<AF> addr, Handler handler,
+                    bool is_cpu_steering,
+                    std::promise<net::Address<AF>> listened) {
+    io::Acceptor<AF, io::Pattern::ASYNC> acceptor;
+    try {
+      acceptor.SetOption(net::SocketOption::REUSEADDR, 1);
+      acceptor.SetOption(net::SocketOption::REUSEPORT, 1);
+      acceptor.Bind(addr);
+      acceptor.Listen();
+      if (is_cpu_steering) {
+        // the program belongs to the reuseport group, attaching it to every
+        // listener checks that each of them has joined the group
+        AttachCpuSteeringProgram(acceptor.GetFd());
+      }
+      listened.set_value(acceptor.GetLocalAddress());
+    } catch (...) {
+      listened.set_exception(std::current_exception());
+      co_return;
+    }
+    serving_acceptors_[index]++;
+    std::exception_ptr error = nullptr;
+    while (!IsShutdown()) {
+      try {
+        auto sock = co_await acceptor.Accept(serve_token_);
+        EnsureFuture(handler(std::move(sock)));
+      } catch (...) {
+        // cancelled by Shutdown
+        if (!IsShutdown()) {
+          error = std::current_exception();
+        }
+        break;
+      }
+    }
+    serving_acceptors_[index]--;
+    if (error != nullptr) {
+      std::rethrow_exception(error);
+    }
+  }
+
+  RuntimeOptions options_{};
+  std::vector<std::thread> threads_{};
+  std::vector<EventLoopWakeUpHandle> handles_{};
+  // the cpu of each loop if pin_threads is set
+  std::vector<int> loop_cpus_{};
+  std::atomic<std::size_t> next_loop_{0};
+  std::atomic<bool> is_shutdown_{false};
+
+  // cancels the acceptors of Serve, each loop exits after its own acceptors
+  // have closed their listeners
+  CancellationToken serve_token_{};
+  // only touched by the thread of each loop
+  std::vector<int> serving_acceptors_{};
+
+  // guards the loop startup and exit
+  std::mutex lock_;
+  std::condition_variable cond_;
+  int started_count_{0};
+  bool is_woken_up_{false};
+};
+
+}  // namespace coro
+}  // namespace arc
+
+#endif /* LIBARC__CORO__RUNTIME_H */
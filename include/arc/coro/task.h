@@ -30,8 +30,12 @@
 #define LIBARC__CORO__TASK_H
 
 #include <arc/concept/coro.h>
+#include <arc/coro/awaiter/dispatch_awaiter.h>
+#include <arc/coro/awaiter/resume_awaiter.h>
 #include <arc/coro/awaiter/time_awaiter.h>
+#include <arc/coro/awaiter/yield_awaiter.h>
 #include <arc/coro/eventloop.h>
+#include <arc/coro/utils/frame_pool.h>
 #include <unistd.h>
 
 #ifdef __clang__
@@ -60,6 +64,16 @@ enum class ReturnType {
 class PromiseBase {
  public:
   PromiseBase() = default;
+
+  // coroutine frames are recycled by the frame pool of each thread
+  static void* operator new(std::size_t size) {
+    return FramePool::Allocate(size);
+  }
+
+  static void operator delete(void* ptr) noexcept {
+    FramePool::Deallocate(ptr);
+  }
+
   auto initial_suspend() { return std::suspend_always{}; }
 
   auto final_suspend() noexcept { return FinalAwaiter{}; }
@@ -68,6 +82,8 @@ class PromiseBase {
     continuation_coro_ = continuation;
   }
 
+  // a detached coroutine has no task left to destroy it, so it destroys its
+  // own frame as soon as it finishes
   void SetNeedClean(bool need_clean = true) { need_manual_clean_ = need_clean; }
 
  protected:
@@ -80,6 +96,10 @@ class PromiseBase {
     template <arc::concepts::PromiseT PromiseType>
     std::coroutine_handle<> await_suspend(
         std::coroutine_handle<PromiseType> coro) noexcept {
+      if (coro.promise().need_manual_clean_) {
+        coro.destroy();
+        return std::noop_coroutine();
+      }
       return coro.promise().continuation_coro_;
     }
 
@@ -113,15 +133,16 @@ class TaskPromise : public PromiseBase {
   TaskPromise* get_return_object() { return this; }
 
   void unhandled_exception() {
-    if (need_manual_clean_) {
-      EventLoop::GetLocalInstance().AddToCleanUpCoroutine(
-          std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
-    }
     return_type_ = ReturnType::EXCEPTION;
     // ::new (static_cast<void*>(std::addressof(exception_ptr_)))
     //     std::exception_ptr(std::current_exception());
     exception_ptr_ = std::current_exception();
     if (continuation_coro_ == std::noop_coroutine()) {
+      // rethrowing skips the final awaiter, the loop destroys the frame later
+      if (need_manual_clean_) {
+        EventLoop::GetLocalInstance().AddToCleanUpCoroutine(
+            std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+      }
       std::rethrow_exception(exception_ptr_);
     }
   }
@@ -131,10 +152,6 @@ class TaskPromise : public PromiseBase {
     if (return_type_ == ReturnType::EXCEPTION) {
       return;
     }
-    if (need_manual_clean_) {
-      EventLoop::GetLocalInstance().AddToCleanUpCoroutine(
-          std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
-    }
     // new placement to initialize the value_ in union
     ::new (static_cast<void*>(std::addressof(value_)))
         T(std::forward<U>(value));
@@ -177,29 +194,22 @@ class TaskPromise<void> : public PromiseBase {
   }
 
   void unhandled_exception() {
-    if (need_manual_clean_) {
-      EventLoop::GetLocalInstance().AddToCleanUpCoroutine(
-          std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
-    }
     return_type_ = ReturnType::EXCEPTION;
     exception_ptr_ = std::current_exception();
     if (continuation_coro_ == std::noop_coroutine()) {
+      // rethrowing skips the final awaiter, the loop destroys the frame later
+      if (need_manual_clean_) {
+        EventLoop::GetLocalInstance().AddToCleanUpCoroutine(
+            std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+      }
       std::rethrow_exception(exception_ptr_);
     }
   }
 
   TaskPromise* get_return_object() { return this; }
 
-  void return_void() {
-    if (need_manual_clean_) {
-      EventLoop::GetLocalInstance().AddToCleanUpCoroutine(
-          std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
-    }
-    if (return_type_ == ReturnType::EXCEPTION) {
-      return;
-    }
-    return_type_ = ReturnType::VALUE;
-  }
+  // nothing to keep, Result only looks for an exception
+  void return_void() {}
 
   void Result() {
     if (return_type_ == ReturnType::EXCEPTION) {
@@ -279,7 +289,20 @@ void StartEventLoop(Task<void>&& task);
 
 TimeAwaiter SleepFor(const std::chrono::steady_clock::duration& duration);
 
-TimeAwaiter Yield();
+YieldAwaiter Yield();
+
+ResumeOnAwaiter ResumeOn(EventLoopWakeUpHandle consumer_id);
+
+// the event loop must be registered as a consumer
+ResumeOnAwaiter ResumeOnEventLoop(EventLoopID event_loop_id);
+
+// dispatches the task once the queue of the consumer is below its capacity,
+// returns false and destroys the task if the consumer is gone
+Task<bool> BoundedDispatchTo(Task<void> task,
+                             EventLoopWakeUpHandle consumer_id);
+
+// picks the consumer with the dispatch policy of the current loop
+Task<bool> BoundedDispatch(Task<void> task);
 
 }  // namespace coro
 }  // namespace arc
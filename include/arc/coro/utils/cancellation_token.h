@@ -32,6 +32,7 @@
 #include <arc/coro/eventloop_group.h>
 #include <arc/coro/events/cancellation_event.h>
 
+#include <atomic>
 #include <memory>
 #include <tuple>
 
@@ -48,17 +49,27 @@ class CancellationTokenCore {
 
   void SetEventAndLoop(BoundEvent* event, EventLoop* loop) {
     std::lock_guard guard(lock_);
+    loop->AddBoundEvent(event);
+    if (cancelled_) {
+      // events waiting after the cancellation are interrupted right away
+      loop->TriggerBoundEvent(event->GetBountEventID(), event);
+      return;
+    }
     registered_events_pairs_.push_back(
         {event->GetBountEventID(), event, loop->GetEventLoopID()});
-    loop->AddBoundEvent(event);
   }
 
   void Cancel() {
     std::lock_guard guard(lock_);
+    cancelled_.store(true, std::memory_order::release);
     TriggerCancel();
     registered_events_pairs_.clear();
   }
 
+  inline bool IsCancelled() const {
+    return cancelled_.load(std::memory_order::acquire);
+  }
+
  private:
   void TriggerCancel() {
     std::lock_guard guard(EventLoopGroup::GetInstance().EventLoopGroupLock());
@@ -73,6 +84,7 @@ class CancellationTokenCore {
   }
 
   std::mutex lock_;
+  std::atomic<bool> cancelled_{false};
 
   // vector of {bound_event_id, trigger_event_pair}
   std::vector<std::tuple<EventID, BoundEvent*, EventLoopID>>
@@ -92,6 +104,8 @@ class CancellationToken {
 
   void Cancel() { core_->Cancel(); }
 
+  bool IsCancelled() const { return core_->IsCancelled(); }
+
  private:
   std::shared_ptr<detail::CancellationTokenCore> core_{nullptr};
 };
@@ -0,0 +1,57 @@
+/*
+ * File: epoch.h
+ * Project: libarc
+ * File Created: Sunday, 18th October 2026 5:14:29 am
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef LIBARC__CORO__UTILS__EPOCH_H
+#define LIBARC__CORO__UTILS__EPOCH_H
+
+namespace arc {
+namespace coro {
+
+// Epoch based reclamation of objects published through atomic pointers.
+// Readers only touch them inside read sections, which write nothing but a
+// record of their own thread. A writer swaps in the new object and calls
+// SynchronizeEpoch before freeing the old one, which waits for the read
+// sections that may still see it.
+//
+// Read sections nest and must not wait for writers.
+class EpochReadGuard {
+ public:
+  EpochReadGuard();
+  ~EpochReadGuard();
+
+  EpochReadGuard(const EpochReadGuard&) = delete;
+  EpochReadGuard& operator=(const EpochReadGuard&) = delete;
+};
+
+// must not be called inside a read section
+void SynchronizeEpoch();
+
+}  // namespace coro
+}  // namespace arc
+
+#endif /* LIBARC__CORO__UTILS__EPOCH_H */
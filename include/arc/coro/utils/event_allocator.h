@@ -0,0 +1,127 @@
+/*
+ * File: event_allocator.h
+ * Project: libarc
+ * File Created: Sunday, 18th October 2026 1:54:54 am
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef LIBARC__CORO__UTILS__EVENT_ALLOCATOR_H
+#define LIBARC__CORO__UTILS__EVENT_ALLOCATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+namespace arc {
+namespace coro {
+
+struct EventAllocatorStats {
+  // allocations served by the free lists
+  std::uint64_t reused_allocations{0};
+  // allocations and deallocations which went to the heap
+  std::uint64_t heap_allocations{0};
+  std::uint64_t heap_deallocations{0};
+};
+
+// EventAllocator caches freed events of each size class in a free list, so
+// that an event loop in a steady state does not touch the heap for events.
+//
+// Every block is a separate heap allocation rounded up to its size class.
+// A block can therefore be cached by another allocator, or be released to the
+// heap after its allocator is gone.
+class EventAllocator {
+ public:
+  EventAllocator() = default;
+  ~EventAllocator();
+
+  EventAllocator(const EventAllocator&) = delete;
+  EventAllocator& operator=(const EventAllocator&) = delete;
+
+  inline void* Allocate(std::size_t size) {
+    std::size_t size_class = GetSizeClass(size);
+    if (size_class < kSizeClasses_) [[likely]] {
+      FreeBlock* block = free_lists_[size_class];
+      if (block != nullptr) [[likely]] {
+        free_lists_[size_class] = block->next;
+        free_counts_[size_class]--;
+        stats_.reused_allocations++;
+        return block;
+      }
+    }
+    stats_.heap_allocations++;
+    return ::operator new(RoundUp(size));
+  }
+
+  inline void Deallocate(void* ptr, std::size_t size) {
+    std::size_t size_class = GetSizeClass(size);
+    if (size_class < kSizeClasses_ &&
+        free_counts_[size_class] < kMaxCachedBlocksPerClass_) [[likely]] {
+      FreeBlock* block = static_cast<FreeBlock*>(ptr);
+      block->next = free_lists_[size_class];
+      free_lists_[size_class] = block;
+      free_counts_[size_class]++;
+      return;
+    }
+    stats_.heap_deallocations++;
+    ::operator delete(ptr);
+  }
+
+  inline const EventAllocatorStats& GetStats() const { return stats_; }
+
+  // the allocator of the event loop of the current thread, nullptr if there
+  // is no event loop
+  static inline EventAllocator* GetLocalInstance() { return local_instance_; }
+  static inline void SetLocalInstance(EventAllocator* allocator) {
+    local_instance_ = allocator;
+  }
+
+  // blocks allocated without an allocator must still fit their size class
+  static inline std::size_t RoundUp(std::size_t size) {
+    return (size + kAlignment_ - 1) & ~(kAlignment_ - 1);
+  }
+
+ private:
+  constexpr static std::size_t kAlignment_ = 16;
+  constexpr static std::size_t kSizeClasses_ = 16;
+  constexpr static std::size_t kMaxCachedBlocksPerClass_ = 4096;
+
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  static inline thread_local EventAllocator* local_instance_{nullptr};
+
+  FreeBlock* free_lists_[kSizeClasses_] = {nullptr};
+  std::size_t free_counts_[kSizeClasses_] = {0};
+  EventAllocatorStats stats_{};
+
+  static inline std::size_t GetSizeClass(std::size_t size) {
+    return (size - 1) / kAlignment_;
+  }
+};
+
+}  // namespace coro
+}  // namespace arc
+
+#endif /* LIBARC__CORO__UTILS__EVENT_ALLOCATOR_H */
@@ -0,0 +1,129 @@
+/*
+ * File: frame_pool.h
+ * Project: libarc
+ * File Created: Sunday, 18th October 2026 2:00:41 am
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef LIBARC__CORO__UTILS__FRAME_POOL_H
+#define LIBARC__CORO__UTILS__FRAME_POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace arc {
+namespace coro {
+
+struct FrameSizeClassStats {
+  // the largest frame served by this size class
+  std::size_t max_frame_size{0};
+  std::uint64_t allocations{0};
+  std::uint64_t pool_hits{0};
+};
+
+struct FramePoolStats {
+  std::uint64_t allocations{0};
+  std::uint64_t pool_hits{0};
+  // frames too large for any size class
+  std::uint64_t oversized_allocations{0};
+  // frames freed by other threads and returned to this pool
+  std::uint64_t remote_deallocations{0};
+  // only size classes which have been used
+  std::vector<FrameSizeClassStats> size_classes{};
+
+  inline double HitRate() const {
+    return allocations == 0 ? 0 : static_cast<double>(pool_hits) / allocations;
+  }
+};
+
+// FramePool caches coroutine frames of each size class per thread. Every
+// frame is prefixed by a header recording the pool it comes from, so a frame
+// destroyed by another thread is pushed back to its owner through a lock-free
+// list, which the owner drains when its own free list runs out.
+//
+// When its thread exits, the pool stays alive until all of its frames which
+// are still in use elsewhere are freed.
+class FramePool {
+ public:
+  static void* Allocate(std::size_t size);
+  static void Deallocate(void* ptr) noexcept;
+
+  // stats of the pool of the current thread
+  static FramePoolStats GetLocalStats();
+
+ private:
+  constexpr static std::size_t kGranularity_ = 64;
+  constexpr static std::size_t kSizeClasses_ = 64;
+  constexpr static std::size_t kMaxCachedFramesPerClass_ = 1024;
+  constexpr static std::uint32_t kOversizedClass_ = UINT32_MAX;
+
+  struct alignas(16) FrameHeader {
+    union {
+      // while the frame is in use
+      FramePool* owner;
+      // while the frame is in a free list
+      FrameHeader* next;
+    };
+    std::uint32_t size_class;
+  };
+
+  // orphans the pool of a thread when the thread exits
+  struct LocalInstanceGuard;
+
+  FrameHeader* free_lists_[kSizeClasses_] = {nullptr};
+  std::size_t free_counts_[kSizeClasses_] = {0};
+  std::atomic<FrameHeader*> remote_frees_{nullptr};
+  // frames of this pool in use, only touched by the owner thread
+  std::int64_t live_frames_{0};
+  // frames in use after the owner thread exited
+  std::atomic<std::int64_t> orphaned_frames_{0};
+
+  // stats
+  std::uint64_t allocations_[kSizeClasses_] = {0};
+  std::uint64_t pool_hits_[kSizeClasses_] = {0};
+  std::uint64_t oversized_allocations_{0};
+  std::uint64_t remote_deallocations_{0};
+
+  FramePool() = default;
+  ~FramePool() = default;
+
+  static FramePool* GetLocalInstance();
+
+  FrameHeader* AllocateFrame(std::uint32_t size_class);
+  void FreeLocal(FrameHeader* header);
+  void FreeRemote(FrameHeader* header);
+  void DrainRemoteFrees();
+  void Orphan();
+
+  static inline std::size_t GetBlockSize(std::uint32_t size_class) {
+    return sizeof(FrameHeader) + (size_class + 1) * kGranularity_;
+  }
+};
+
+}  // namespace coro
+}  // namespace arc
+
+#endif /* LIBARC__CORO__UTILS__FRAME_POOL_H */
@@ -0,0 +1,197 @@
+/*
+ * File: loop_profile.h
+ * Project: libarc
+ * File Created: Sunday, 18th October 2026 2:21:24 am
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef LIBARC__CORO__UTILS__LOOP_PROFILE_H
+#define LIBARC__CORO__UTILS__LOOP_PROFILE_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace arc {
+namespace coro {
+
+// A histogram of durations in nanoseconds, bucket i counts durations in
+// [2^i, 2^(i+1)).
+struct LatencyHistogram {
+  constexpr static int kBuckets = 40;
+
+  std::uint64_t count{0};
+  std::uint64_t total_ns{0};
+  std::uint64_t max_ns{0};
+  std::uint64_t buckets[kBuckets] = {0};
+
+  inline double Mean() const {
+    return count == 0 ? 0 : static_cast<double>(total_ns) / count;
+  }
+
+  // the upper bound of the bucket where the percentile falls in
+  inline std::uint64_t Percentile(double percentile) const {
+    std::uint64_t target = static_cast<std::uint64_t>(percentile * count);
+    std::uint64_t accumulated = 0;
+    for (int i = 0; i < kBuckets; i++) {
+      accumulated += buckets[i];
+      if (accumulated > target || accumulated == count) {
+        return std::min(max_ns, (std::uint64_t{1} << (i + 1)) - 1);
+      }
+    }
+    return max_ns;
+  }
+};
+
+struct EventLoopProfile {
+  std::uint64_t iterations{0};
+
+  // events returned by the poller
+  std::uint64_t io_events{0};
+  std::uint64_t time_events{0};
+  std::uint64_t user_events{0};
+  std::uint64_t bound_events{0};
+  // epoll_ctl calls, or poll requests queued by io_uring
+  std::uint64_t poller_control_calls{0};
+
+  // only recorded if EventLoopOptions::profile_timing is set
+  LatencyHistogram wait{};
+  LatencyHistogram resume{};
+  LatencyHistogram trim{};
+  LatencyHistogram consume_coroutine{};
+  LatencyHistogram produce_coroutine{};
+  LatencyHistogram trim_io_events{};
+  LatencyHistogram trim_time_events{};
+  LatencyHistogram clean_up_coroutines{};
+};
+
+namespace detail {
+
+// A counter only written by the loop thread and readable from any thread,
+// it costs the same as a plain integer on the writer side.
+class ProfileCounter {
+ public:
+  inline void Add(std::uint64_t value) {
+    value_.store(value_.load(std::memory_order::relaxed) + value,
+                 std::memory_order::relaxed);
+  }
+  inline void SetMax(std::uint64_t value) {
+    if (value > value_.load(std::memory_order::relaxed)) {
+      value_.store(value, std::memory_order::relaxed);
+    }
+  }
+  inline std::uint64_t Get() const {
+    return value_.load(std::memory_order::relaxed);
+  }
+
+ private:
+  std::atomic<std::uint64_t> value_{0};
+};
+
+class ProfileHistogram {
+ public:
+  inline void Record(std::int64_t duration) {
+    std::uint64_t value = duration > 0 ? duration : 0;
+    int bucket = 63 - __builtin_clzll(value | 1);
+    count_.Add(1);
+    total_ns_.Add(value);
+    max_ns_.SetMax(value);
+    buckets_[bucket < LatencyHistogram::kBuckets
+                 ? bucket
+                 : LatencyHistogram::kBuckets - 1]
+        .Add(1);
+  }
+
+  inline LatencyHistogram Snapshot() const {
+    LatencyHistogram histogram{};
+    histogram.count = count_.Get();
+    histogram.total_ns = total_ns_.Get();
+    histogram.max_ns = max_ns_.Get();
+    for (int i = 0; i < LatencyHistogram::kBuckets; i++) {
+      histogram.buckets[i] = buckets_[i].Get();
+    }
+    return histogram;
+  }
+
+ private:
+  ProfileCounter count_;
+  ProfileCounter total_ns_;
+  ProfileCounter max_ns_;
+  ProfileCounter buckets_[LatencyHistogram::kBuckets];
+};
+
+// Records the time from its construction to its destruction, does nothing
+// if the histogram is nullptr.
+class ProfileScope {
+ public:
+  explicit ProfileScope(ProfileHistogram* histogram) : histogram_(histogram) {
+    if (histogram_ != nullptr) [[unlikely]] {
+      start_ = std::chrono::steady_clock::now();
+    }
+  }
+  ~ProfileScope() {
+    if (histogram_ != nullptr) [[unlikely]] {
+      histogram_->Record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             std::chrono::steady_clock::now() - start_)
+                             .count());
+    }
+  }
+
+  ProfileScope(const ProfileScope&) = delete;
+  ProfileScope& operator=(const ProfileScope&) = delete;
+
+ private:
+  ProfileHistogram* histogram_{nullptr};
+  std::chrono::steady_clock::time_point start_{};
+};
+
+// counters kept by the poller
+struct PollerCounters {
+  ProfileCounter io_events;
+  ProfileCounter time_events;
+  ProfileCounter user_events;
+  ProfileCounter bound_events;
+  ProfileCounter control_calls;
+};
+
+// timing histograms kept by the event loop
+struct EventLoopTimings {
+  ProfileCounter iterations;
+  ProfileHistogram wait;
+  ProfileHistogram resume;
+  ProfileHistogram trim;
+  ProfileHistogram consume_coroutine;
+  ProfileHistogram produce_coroutine;
+  ProfileHistogram trim_io_events;
+  ProfileHistogram trim_time_events;
+  ProfileHistogram clean_up_coroutines;
+};
+
+}  // namespace detail
+
+}  // namespace coro
+}  // namespace arc
+
+#endif /* LIBARC__CORO__UTILS__LOOP_PROFILE_H */
@@ -0,0 +1,102 @@
+/*
+ * File: ring_buffer.h
+ * Project: libarc
+ * File Created: Sunday, 18th October 2026 3:36:28 am
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef LIBARC__CORO__UTILS__RING_BUFFER_H
+#define LIBARC__CORO__UTILS__RING_BUFFER_H
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <utility>
+
+namespace arc {
+namespace coro {
+
+// FIFO buffer in a power of two sized array. It only allocates when it is
+// full, which doubles the array, so a buffer which is drained regularly stops
+// allocating once it has grown to its working size.
+template <typename T>
+class RingBuffer {
+ public:
+  explicit RingBuffer(std::size_t capacity = kDefaultCapacity_)
+      : capacity_(std::bit_ceil(std::max<std::size_t>(capacity, 1))),
+        data_(std::make_unique<T[]>(capacity_)) {}
+
+  RingBuffer(const RingBuffer&) = delete;
+  RingBuffer& operator=(const RingBuffer&) = delete;
+
+  inline void PushBack(const T& item) {
+    if (size_ == capacity_) [[unlikely]] {
+      Grow();
+    }
+    data_[(head_ + size_) & (capacity_ - 1)] = item;
+    size_++;
+  }
+
+  inline T& Front() { return data_[head_]; }
+
+  inline void PopFront(std::size_t count = 1) {
+    head_ = (head_ + count) & (capacity_ - 1);
+    size_ -= count;
+  }
+
+  // the items from the front up to the end of the array or the last item
+  inline std::span<T> FrontSegment() {
+    return std::span<T>(data_.get() + head_,
+                        std::min(size_, capacity_ - head_));
+  }
+
+  inline std::size_t Size() const { return size_; }
+  inline bool Empty() const { return size_ == 0; }
+  inline std::size_t Capacity() const { return capacity_; }
+
+ private:
+  constexpr static std::size_t kDefaultCapacity_ = 64;
+
+  void Grow() {
+    auto data = std::make_unique<T[]>(capacity_ * 2);
+    for (std::size_t i = 0; i < size_; i++) {
+      data[i] = std::move(data_[(head_ + i) & (capacity_ - 1)]);
+    }
+    data_ = std::move(data);
+    capacity_ *= 2;
+    head_ = 0;
+  }
+
+  std::size_t capacity_;
+  std::unique_ptr<T[]> data_;
+  std::size_t head_{0};
+  std::size_t size_{0};
+};
+
+}  // namespace coro
+}  // namespace arc
+
+#endif /* LIBARC__CORO__UTILS__RING_BUFFER_H */
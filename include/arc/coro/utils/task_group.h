@@ -0,0 +1,214 @@
+/*
+ * File: task_group.h
+ * Project: libarc
+ * File Created: Sunday, 18th October 2026 4:08:07 am
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef LIBARC__CORO__UTILS__TASK_GROUP_H
+#define LIBARC__CORO__UTILS__TASK_GROUP_H
+
+#include <arc/concept/coro.h>
+#include <arc/coro/eventloop.h>
+#include <arc/coro/eventloop_group.h>
+#include <arc/coro/events/user_event.h>
+#include <arc/coro/task.h>
+#include <arc/coro/utils/cancellation_token.h>
+
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+namespace arc {
+namespace coro {
+
+namespace detail {
+
+class TaskGroupState {
+ public:
+  explicit TaskGroupState(const CancellationToken& token) : token_(token) {}
+
+  inline CancellationToken& GetToken() { return token_; }
+  inline bool IsIdle() const {
+    return running_.load(std::memory_order::acquire) == 0;
+  }
+
+  inline void AddChild() { running_.fetch_add(1, std::memory_order::relaxed); }
+
+  // the first failure is kept and cancels the rest of the children
+  void Fail(std::exception_ptr exception) {
+    {
+      std::lock_guard guard(lock_);
+      if (exception_ != nullptr) {
+        return;
+      }
+      exception_ = exception;
+    }
+    token_.Cancel();
+  }
+
+  void FinishChild() {
+    if (running_.fetch_sub(1, std::memory_order::acq_rel) != 1) {
+      return;
+    }
+    std::optional<std::pair<EventLoopID, EventID>> waiter;
+    {
+      std::lock_guard guard(lock_);
+      waiter.swap(waiter_);
+    }
+    if (waiter) {
+      Wake(*waiter);
+    }
+  }
+
+  // returns false if every child has already finished
+  bool SetWaiter(EventLoopID event_loop_id, EventID event_id) {
+    std::lock_guard guard(lock_);
+    if (IsIdle()) {
+      return false;
+    }
+    waiter_.emplace(event_loop_id, event_id);
+    return true;
+  }
+
+  void RethrowIfFailed() {
+    std::lock_guard guard(lock_);
+    if (exception_ != nullptr) {
+      std::rethrow_exception(std::exchange(exception_, nullptr));
+    }
+  }
+
+ private:
+  static void Wake(const std::pair<EventLoopID, EventID>& waiter) {
+    auto& group = EventLoopGroup::GetInstance();
+    std::lock_guard guard(group.EventLoopGroupLock());
+    auto loop = group.GetEventLoopNoLock(waiter.first);
+    if (loop) {
+      loop->TriggerUserEvent(waiter.second);
+    }
+  }
+
+  CancellationToken token_;
+  std::atomic<int> running_{0};
+  std::mutex lock_;
+  std::exception_ptr exception_{nullptr};
+  std::optional<std::pair<EventLoopID, EventID>> waiter_{};
+};
+
+// suspends until every child of the group has finished
+class [[nodiscard]] TaskGroupAwaiter {
+ public:
+  explicit TaskGroupAwaiter(std::shared_ptr<TaskGroupState> state)
+      : state_(std::move(state)) {}
+
+  bool await_ready() { return state_->IsIdle(); }
+
+  template <arc::concepts::PromiseT PromiseType>
+  void await_suspend(std::coroutine_handle<PromiseType> handle) {
+    UserEvent* event = new UserEvent(handle);
+    EventLoop* loop = &EventLoop::GetLocalInstance();
+    loop->AddUserEvent(event);
+    if (!state_->SetWaiter(loop->GetEventLoopID(), event->GetEventID())) {
+      loop->TriggerUserEvent(event->GetEventID());
+    }
+  }
+
+  void await_resume() { state_->RethrowIfFailed(); }
+
+ private:
+  std::shared_ptr<TaskGroupState> state_;
+};
+
+}  // namespace detail
+
+// A nursery for child tasks. The group must be awaited with Wait before it
+// goes away, which returns once every child has finished and rethrows the
+// first exception a child threw. A failing child cancels the token of the
+// group, so the other children should pass GetToken to their io and
+// condition waits to be interrupted. Sleeps cannot be cancelled.
+class TaskGroup {
+ public:
+  TaskGroup() : TaskGroup(CancellationToken()) {}
+  // cancelling the token cancels the children, a failing child cancels it too
+  explicit TaskGroup(const CancellationToken& token)
+      : state_(std::make_shared<detail::TaskGroupState>(token)) {}
+
+  TaskGroup(const TaskGroup&) = delete;
+  TaskGroup& operator=(const TaskGroup&) = delete;
+
+  // children still running when the group goes away are cancelled
+  ~TaskGroup() {
+    if (!state_->IsIdle()) {
+      state_->GetToken().Cancel();
+    }
+  }
+
+  // starts the child on the current loop right away
+  void Spawn(Task<void> task) {
+    state_->AddChild();
+    EnsureFuture(RunChild(state_, std::move(task)));
+  }
+
+  // waits while the queue of the consumer is full, returns false and drops
+  // the child if the consumer is gone
+  Task<bool> SpawnOn(Task<void> task, EventLoopWakeUpHandle consumer_id) {
+    auto state = state_;
+    state->AddChild();
+    bool is_dispatched = co_await BoundedDispatchTo(
+        RunChild(state, std::move(task)), consumer_id);
+    if (!is_dispatched) {
+      state->FinishChild();
+    }
+    co_return is_dispatched;
+  }
+
+  detail::TaskGroupAwaiter Wait() { return detail::TaskGroupAwaiter(state_); }
+
+  void Cancel() { state_->GetToken().Cancel(); }
+  bool IsCancelled() const { return state_->GetToken().IsCancelled(); }
+  const CancellationToken& GetToken() const { return state_->GetToken(); }
+
+ private:
+  static Task<void> RunChild(std::shared_ptr<detail::TaskGroupState> state,
+                             Task<void> task) {
+    try {
+      // the child frame goes away before the group is told
+      Task<void> child = std::move(task);
+      co_await child;
+    } catch (...) {
+      state->Fail(std::current_exception());
+    }
+    state->FinishChild();
+  }
+
+  std::shared_ptr<detail::TaskGroupState> state_;
+};
+
+}  // namespace coro
+}  // namespace arc
+
+#endif /* LIBARC__CORO__UTILS__TASK_GROUP_H */
@@ -0,0 +1,96 @@
+/*
+ * File: timing_wheel.h
+ * Project: libarc
+ * File Created: Sunday, 18th October 2026 1:44:55 am
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef LIBARC__CORO__UTILS__TIMING_WHEEL_H
+#define LIBARC__CORO__UTILS__TIMING_WHEEL_H
+
+#include <arc/coro/events/time_event.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace arc {
+namespace coro {
+
+// Hierarchical timing wheel of time events. Adding and removing an event are
+// O(1), and an event is moved to lower levels at most kLevels_ - 1 times
+// before it expires.
+//
+// Times are divided into ticks of tick_size. An event lives in the level of
+// the highest bit in which its wakeup tick differs from the current tick, so
+// every level only holds events of the current window of its upper level.
+class TimingWheel {
+ public:
+  TimingWheel(std::int64_t current_time, std::int64_t tick_size = 1)
+      : tick_size_(tick_size), current_tick_(current_time / tick_size) {}
+  ~TimingWheel() = default;
+
+  TimingWheel(const TimingWheel&) = delete;
+  TimingWheel& operator=(const TimingWheel&) = delete;
+
+  void Add(TimeEvent* event);
+  void Remove(TimeEvent* event);
+
+  // Pops one event whose wakeup tick is not later than the tick of
+  // current_time, returns nullptr if there is none.
+  TimeEvent* PopExpired(std::int64_t current_time);
+
+  // Returns the earliest time at which the wheel needs to be advanced, or -1
+  // if the wheel is empty. It is never later than the earliest wakeup time.
+  std::int64_t GetNextExpireTime() const;
+
+  inline std::size_t Size() const { return size_; }
+  inline bool Empty() const { return size_ == 0; }
+
+ private:
+  constexpr static int kLevelBits_ = 6;
+  constexpr static int kSlotsPerLevel_ = 1 << kLevelBits_;
+  constexpr static int kLevels_ = 6;
+  constexpr static int kWheelBits_ = kLevelBits_ * kLevels_;
+  constexpr static int kExpiredSlot_ = kLevels_ * kSlotsPerLevel_;
+  constexpr static int kOverflowSlot_ = kExpiredSlot_ + 1;
+
+  const std::int64_t tick_size_{1};
+  std::int64_t current_tick_{0};
+  std::size_t size_{0};
+  std::uint64_t occupied_slots_[kLevels_] = {0};
+  // circular lists, slots_[i] points to the head
+  TimeEvent* slots_[kOverflowSlot_ + 1] = {nullptr};
+
+  void Place(TimeEvent* event);
+  void Link(TimeEvent* event, int slot);
+  void Unlink(TimeEvent* event);
+  std::int64_t GetNextExpireTick() const;
+  bool Advance(std::int64_t current_tick);
+  void SetCurrentTick(std::int64_t current_tick);
+};
+
+}  // namespace coro
+}  // namespace arc
+
+#endif /* LIBARC__CORO__UTILS__TIMING_WHEEL_H */
@@ -0,0 +1,376 @@
+/*
+ * File: when.h
+ * Project: libarc
+ * File Created: Sunday, 18th October 2026 3:43:28 am
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef LIBARC__CORO__UTILS__WHEN_H
+#define LIBARC__CORO__UTILS__WHEN_H
+
+#include <arc/coro/task.h>
+#include <arc/coro/utils/frame_pool.h>
+#include <arc/exception/base.h>
+
+#include <array>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace arc {
+namespace coro {
+
+template <typename T>
+struct WhenAnyResult {
+  std::size_t index;
+  T value;
+};
+
+template <>
+struct WhenAnyResult<void> {
+  std::size_t index;
+};
+
+namespace detail {
+
+// notified by each child when it finishes, returns the coroutine to resume
+class WhenNotifier {
+ public:
+  virtual ~WhenNotifier() = default;
+  virtual std::coroutine_handle<> Arrive(std::size_t index) = 0;
+};
+
+// Wraps one child task, it runs on the loop which starts it and destroys its
+// own frame when it finishes, so nothing has to wait for it.
+class WhenChild {
+ public:
+  class promise_type {
+   public:
+    static void* operator new(std::size_t size) {
+      return FramePool::Allocate(size);
+    }
+    static void operator delete(void* ptr) noexcept {
+      FramePool::Deallocate(ptr);
+    }
+
+    WhenChild get_return_object() {
+      return WhenChild(
+          std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    auto final_suspend() noexcept { return FinalAwaiter{}; }
+    void return_void() {}
+    // the child body catches everything
+    void unhandled_exception() { std::terminate(); }
+
+   private:
+    friend class WhenChild;
+    struct FinalAwaiter {
+      bool await_ready() noexcept { return false; }
+      std::coroutine_handle<> await_suspend(
+          std::coroutine_handle<promise_type> handle) noexcept {
+        auto& promise = handle.promise();
+        auto next = promise.notifier_->Arrive(promise.index_);
+        handle.destroy();
+        return next;
+      }
+      void await_resume() noexcept {}
+    };
+
+    WhenNotifier* notifier_{nullptr};
+    std::size_t index_{0};
+  };
+
+  WhenChild(WhenChild&& other)
+      : coroutine_(std::exchange(other.coroutine_, nullptr)) {}
+  WhenChild(const WhenChild&) = delete;
+  ~WhenChild() {
+    if (coroutine_) {
+      coroutine_.destroy();
+    }
+  }
+
+  // the frame owns itself once it is started
+  void Start(WhenNotifier* notifier, std::size_t index) {
+    auto coroutine = std::exchange(coroutine_, nullptr);
+    coroutine.promise().notifier_ = notifier;
+    coroutine.promise().index_ = index;
+    coroutine.resume();
+  }
+
+ private:
+  WhenChild(std::coroutine_handle<promise_type> coroutine)
+      : coroutine_(coroutine) {}
+
+  std::coroutine_handle<promise_type> coroutine_{nullptr};
+};
+
+template <typename T>
+struct WhenSlot {
+  std::optional<T> value{};
+  std::exception_ptr exception{nullptr};
+};
+
+template <>
+struct WhenSlot<void> {
+  std::exception_ptr exception{nullptr};
+};
+
+template <typename T>
+using WhenValue = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+// keep_alive holds the slot if the parent may finish first
+template <typename T>
+WhenChild MakeWhenChild(
+    Task<T> task, WhenSlot<T>* slot,
+    [[maybe_unused]] std::shared_ptr<void> keep_alive = nullptr) {
+  try {
+    if constexpr (std::is_void_v<T>) {
+      co_await task;
+    } else {
+      slot->value.emplace(co_await task);
+    }
+  } catch (...) {
+    slot->exception = std::current_exception();
+  }
+}
+
+template <typename T>
+WhenValue<T> TakeWhenValue(WhenSlot<T>& slot) {
+  if (slot.exception) {
+    std::rethrow_exception(slot.exception);
+  }
+  if constexpr (std::is_void_v<T>) {
+    return std::monostate{};
+  } else {
+    return std::move(*slot.value);
+  }
+}
+
+// the parent also holds one count while it starts the children, so that
+// children finishing without suspending do not resume it
+class WhenAllCounter : public WhenNotifier {
+ public:
+  explicit WhenAllCounter(std::size_t count) : remaining_(count + 1) {}
+
+  std::coroutine_handle<> Arrive(std::size_t) override {
+    if (remaining_.fetch_sub(1, std::memory_order::acq_rel) == 1) {
+      return parent_;
+    }
+    return std::noop_coroutine();
+  }
+
+  void SetParent(std::coroutine_handle<> parent) { parent_ = parent; }
+
+  // returns false if all children have finished
+  bool Leave() {
+    return remaining_.fetch_sub(1, std::memory_order::acq_rel) > 1;
+  }
+
+ private:
+  std::atomic<std::size_t> remaining_;
+  std::coroutine_handle<> parent_{nullptr};
+};
+
+template <typename It>
+class [[nodiscard]] WhenAllAwaiter {
+ public:
+  WhenAllAwaiter(WhenAllCounter& counter, It begin, It end)
+      : counter_(counter), begin_(begin), end_(end) {}
+
+  bool await_ready() { return begin_ == end_; }
+
+  bool await_suspend(std::coroutine_handle<> parent) {
+    counter_.SetParent(parent);
+    std::size_t index = 0;
+    for (auto it = begin_; it != end_; it++) {
+      it->Start(&counter_, index++);
+    }
+    return counter_.Leave();
+  }
+
+  void await_resume() {}
+
+ private:
+  WhenAllCounter& counter_;
+  It begin_;
+  It end_;
+};
+
+// shared by the parent and the children, as the children which lose keep
+// running after the parent is resumed
+template <typename T>
+class WhenAnyState : public WhenNotifier {
+ public:
+  std::coroutine_handle<> Arrive(std::size_t index) override {
+    if (is_finished_.exchange(true, std::memory_order::acq_rel)) {
+      return std::noop_coroutine();
+    }
+    winner_ = index;
+    return Release() ? parent_ : std::noop_coroutine();
+  }
+
+  void SetParent(std::coroutine_handle<> parent) { parent_ = parent; }
+
+  // the parent and the winner both release it, returns true for the later
+  // one, which resumes the parent
+  bool Release() {
+    return remaining_.fetch_sub(1, std::memory_order::acq_rel) == 1;
+  }
+
+  std::vector<WhenSlot<T>> slots;
+
+  WhenAnyResult<T> TakeResult() {
+    auto& slot = slots[winner_];
+    if (slot.exception) {
+      std::rethrow_exception(slot.exception);
+    }
+    if constexpr (std::is_void_v<T>) {
+      return WhenAnyResult<void>{winner_};
+    } else {
+      return WhenAnyResult<T>{winner_, std::move(*slot.value)};
+    }
+  }
+
+ private:
+  std::atomic<bool> is_finished_{false};
+  std::atomic<int> remaining_{2};
+  std::size_t winner_{0};
+  std::coroutine_handle<> parent_{nullptr};
+};
+
+template <typename T>
+class [[nodiscard]] WhenAnyAwaiter {
+ public:
+  WhenAnyAwaiter(WhenAnyState<T>& state, std::vector<WhenChild>& children)
+      : state_(state), children_(children) {}
+
+  bool await_ready() { return false; }
+
+  bool await_suspend(std::coroutine_handle<> parent) {
+    state_.SetParent(parent);
+    for (std::size_t i = 0; i < children_.size(); i++) {
+      children_[i].Start(&state_, i);
+    }
+    return !state_.Release();
+  }
+
+  void await_resume() {}
+
+ private:
+  WhenAnyState<T>& state_;
+  std::vector<WhenChild>& children_;
+};
+
+template <typename... Ts, std::size_t... Is>
+Task<std::tuple<WhenValue<Ts>...>> WhenAllImpl(
+    std::index_sequence<Is...>, Task<Ts>... tasks) {
+  std::tuple<WhenSlot<Ts>...> slots;
+  std::array<WhenChild, sizeof...(Ts)> children{
+      MakeWhenChild(std::move(tasks), &std::get<Is>(slots))...};
+  WhenAllCounter counter(sizeof...(Ts));
+  co_await WhenAllAwaiter(counter, children.begin(), children.end());
+  // braces evaluate the values, and so rethrow, in argument order
+  co_return std::tuple<WhenValue<Ts>...>{
+      TakeWhenValue(std::get<Is>(slots))...};
+}
+
+}  // namespace detail
+
+// Starts all tasks on the current loop and resumes the caller once when all
+// of them have finished, void results are std::monostate. If any of them
+// throws, the first exception in argument order is rethrown after all have
+// finished.
+template <typename... Ts>
+Task<std::tuple<detail::WhenValue<Ts>...>> WhenAll(Task<Ts>... tasks) {
+  return detail::WhenAllImpl(std::index_sequence_for<Ts...>{},
+                             std::move(tasks)...);
+}
+
+template <typename T>
+Task<std::conditional_t<std::is_void_v<T>, void, std::vector<T>>> WhenAll(
+    std::vector<Task<T>> tasks) {
+  std::vector<detail::WhenSlot<T>> slots(tasks.size());
+  std::vector<detail::WhenChild> children;
+  children.reserve(tasks.size());
+  for (std::size_t i = 0; i < tasks.size(); i++) {
+    children.push_back(detail::MakeWhenChild(std::move(tasks[i]), &slots[i]));
+  }
+  detail::WhenAllCounter counter(children.size());
+  co_await detail::WhenAllAwaiter(counter, children.begin(), children.end());
+  if constexpr (std::is_void_v<T>) {
+    for (auto& slot : slots) {
+      detail::TakeWhenValue(slot);
+    }
+  } else {
+    std::vector<T> results;
+    results.reserve(slots.size());
+    for (auto& slot : slots) {
+      results.push_back(detail::TakeWhenValue(slot));
+    }
+    co_return results;
+  }
+}
+
+// Starts all tasks on the current loop and resumes the caller once when the
+// first of them finishes, with its index and result or exception. The others
+// keep running to their end in the background, cancel them with a
+// CancellationToken if they should stop early.
+template <typename T>
+Task<WhenAnyResult<T>> WhenAny(std::vector<Task<T>> tasks) {
+  if (tasks.empty()) {
+    throw arc::exception::detail::ExceptionBase("WhenAny of no task");
+  }
+  auto state = std::make_shared<detail::WhenAnyState<T>>();
+  state->slots.resize(tasks.size());
+  std::vector<detail::WhenChild> children;
+  children.reserve(tasks.size());
+  for (std::size_t i = 0; i < tasks.size(); i++) {
+    children.push_back(
+        detail::MakeWhenChild(std::move(tasks[i]), &state->slots[i], state));
+  }
+  co_await detail::WhenAnyAwaiter<T>(*state, children);
+  co_return state->TakeResult();
+}
+
+template <typename T, typename... Ts>
+requires(std::is_same_v<T, Ts>&&...) Task<WhenAnyResult<T>> WhenAny(
+    Task<T> task, Task<Ts>... tasks) {
+  std::vector<Task<T>> all_tasks;
+  all_tasks.reserve(sizeof...(Ts) + 1);
+  all_tasks.push_back(std::move(task));
+  (all_tasks.push_back(std::move(tasks)), ...);
+  return WhenAny(std::move(all_tasks));
+}
+
+}  // namespace coro
+}  // namespace arc
+
+#endif /* LIBARC__CORO__UTILS__WHEN_H */
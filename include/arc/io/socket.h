@@ -31,6 +31,10 @@
 
 #include "socket_base.h"
 
+#include <arc/coro/generator.h>
+
+#include <queue>
+
 namespace arc {
 namespace io {
 
@@ -57,6 +61,7 @@ class Socket : public detail::SocketBase<AF,
                            P>() {
     if constexpr (PP == Pattern::ASYNC) {
       this->SetNonBlocking(true);
+      coro::EventLoop::ResetLocalIOInterest(this->fd_);
     }
   }
   Socket(int fd, const net::Address<AF>& in_addr)
@@ -67,6 +72,7 @@ class Socket : public detail::SocketBase<AF,
                            P>(fd, in_addr) {
     if constexpr (PP == Pattern::ASYNC) {
       this->SetNonBlocking(true);
+      coro::EventLoop::ResetLocalIOInterest(this->fd_);
     }
   }
   Socket(const Socket&) = delete;
@@ -177,6 +183,25 @@ class Socket : public detail::SocketBase<AF,
         this->fd_, io::IOType::READ, timeout);
   }
 
+  // yields the number of bytes received into buf each time until the peer
+  // closes the connection, throws IOException on errors. The socket must
+  // outlive the stream
+  template <net::Protocol UP = P, Pattern UPP = PP>
+  requires(UP == net::Protocol::TCP) && (UPP == Pattern::ASYNC)
+      coro::AsyncGenerator<ssize_t> RecvStream(char* buf,
+                                               int max_recv_bytes) {
+    while (true) {
+      ssize_t received = co_await Recv(buf, max_recv_bytes);
+      if (received < 0) {
+        throw arc::exception::IOException("Recv Error");
+      }
+      if (received == 0) {
+        co_return;
+      }
+      co_yield received;
+    }
+  }
+
   template <net::Protocol UP = P, Pattern UPP = PP>
   requires(UP == net::Protocol::TCP) &&
       (UPP == Pattern::SYNC) void Connect(const net::Address<AF>& addr) {
@@ -275,11 +300,41 @@ class Acceptor : virtual public Socket<AF, net::Protocol::TCP, PP> {
 
   template <Pattern UPP = PP>
   requires(UPP == Pattern::ASYNC) auto Accept() {
-    return coro::IOAwaiter(
+    auto awaiter = coro::IOAwaiter(
         std::bind(&Acceptor<AF, UPP>::template IOReadyFunctor<UPP>, this),
         std::bind(&Acceptor<AF, UPP>::template GetNextAvailableSocket<UPP>,
                   this),
         this->fd_, io::IOType::READ);
+    // pending connections are all accepted at once
+    awaiter.SetDrainsFd();
+    return awaiter;
+  }
+
+  // throws IOException if the wait is interrupted by the token, unless a
+  // connection is ready first. Connections pending by then are kept for the
+  // next Accept
+  template <Pattern UPP = PP>
+  requires(UPP == Pattern::ASYNC) auto Accept(
+      const coro::CancellationToken& token) {
+    auto awaiter = coro::IOAwaiter(
+        std::bind(&Acceptor<AF, UPP>::template IOReadyFunctor<UPP>, this),
+        std::bind(&Acceptor<AF, UPP>::template GetNextAvailableSocket<UPP>,
+                  this),
+        std::bind(&Acceptor<AF, UPP>::template ThrowAcceptCancelled<UPP>,
+                  this),
+        this->fd_, io::IOType::READ, token);
+    awaiter.SetDrainsFd();
+    return awaiter;
+  }
+
+  // yields accepted sockets until accepting fails, the acceptor must outlive
+  // the stream
+  template <Pattern UPP = PP>
+  requires(UPP == Pattern::ASYNC)
+      coro::AsyncGenerator<Socket<AF, net::Protocol::TCP, UPP>> AcceptStream() {
+    while (true) {
+      co_yield co_await Accept();
+    }
   }
 
  protected:
@@ -297,6 +352,27 @@ class Acceptor : virtual public Socket<AF, net::Protocol::TCP, PP> {
       accepted_sockets_.pop();
       return std::move(next_socket);
     }
+    AcceptPendingSockets<UPP>();
+    if (accepted_sockets_.empty()) {
+      // woken up without a pending connection
+      throw arc::exception::IOException("Accept Error");
+    }
+    Socket<AF, net::Protocol::TCP, UPP> next_socket =
+        std::move(accepted_sockets_.front());
+    accepted_sockets_.pop();
+    return std::move(next_socket);
+  }
+
+  template <Pattern UPP = PP>
+  requires(UPP == Pattern::ASYNC)
+      Socket<AF, net::Protocol::TCP, UPP> ThrowAcceptCancelled() {
+    // drains the fd as the awaiter promised the poller
+    AcceptPendingSockets<UPP>();
+    throw arc::exception::IOException("Accept Cancelled");
+  }
+
+  template <Pattern UPP = PP>
+  requires(UPP == Pattern::ASYNC) void AcceptPendingSockets() {
     typename detail::SocketBase<AF, net::SocketType::STREAM,
                                 net::Protocol::TCP>::CAddressType in_addr;
     socklen_t addrlen = sizeof(in_addr);
@@ -312,10 +388,6 @@ class Acceptor : virtual public Socket<AF, net::Protocol::TCP, PP> {
       }
       accepted_sockets_.emplace(accept_fd, in_addr);
     }
-    Socket<AF, net::Protocol::TCP, UPP> next_socket =
-        std::move(accepted_sockets_.front());
-    accepted_sockets_.pop();
-    return std::move(next_socket);
   }
 
   std::queue<Socket<AF, net::Protocol::TCP, PP>> accepted_sockets_;
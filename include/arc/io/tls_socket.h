@@ -225,6 +225,22 @@ class TLSSocket : virtual public Socket<AF, net::Protocol::TCP, PP> {
     }
   }
 
+  // ends once the peer closes the connection, throws IOException on errors
+  template <Pattern UPP = PP>
+  requires(UPP == Pattern::ASYNC) coro::AsyncGenerator<ssize_t> RecvStream(
+      char* buf, int max_recv_bytes) {
+    while (true) {
+      ssize_t received = co_await Recv(buf, max_recv_bytes);
+      if (received < 0) {
+        throw arc::exception::IOException("Recv Error");
+      }
+      if (received == 0) {
+        co_return;
+      }
+      co_yield received;
+    }
+  }
+
   template <Pattern UPP = PP>
   requires(UPP == Pattern::SYNC) int Send(const void* data, int num) {
     return SSL_write(ssl_.ssl, data, num);
@@ -506,6 +522,14 @@ class TLSAcceptor : public TLSSocket<AF, PP>, public Acceptor<AF, PP> {
     co_return std::move(tls_socket);
   }
 
+  template <Pattern UPP = PP>
+  requires(UPP == Pattern::ASYNC)
+      coro::AsyncGenerator<TLSSocket<AF, PP>> AcceptStream() {
+    while (true) {
+      co_yield co_await Accept();
+    }
+  }
+
  private : bool TLSIOReadyFunctor() { return false; }
   void TLSIOResumeFunctor() { return; }
 
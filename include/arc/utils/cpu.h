@@ -0,0 +1,56 @@
+/*
+ * File: cpu.h
+ * Project: libarc
+ * File Created: Sunday, 18th October 2026 3:00:52 am
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef LIBARC__UTILS__CPU_H
+#define LIBARC__UTILS__CPU_H
+
+#include <vector>
+
+namespace arc {
+namespace utils {
+
+int GetCpuCount();
+// the cpus in the affinity mask of the process, in ascending order, which
+// may be fewer and not contiguous under cpusets
+std::vector<int> GetAllowedCpus();
+// at least 1, nodes are read from sysfs
+int GetNumaNodeCount();
+// 0 if it cannot be told
+int GetNumaNodeOfCpu(int cpu);
+std::vector<int> GetCpusOfNumaNode(int node);
+// the node of the cpu the current thread is running on, -1 if unknown
+int GetCurrentNumaNode();
+
+void SetCurrentThreadAffinity(const std::vector<int>& cpus);
+// memory allocated by the current thread afterwards prefers the node
+void SetCurrentThreadPreferredNumaNode(int node);
+
+}  // namespace utils
+}  // namespace arc
+
+#endif /* LIBARC__UTILS__CPU_H */
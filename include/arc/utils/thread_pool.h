@@ -67,10 +67,19 @@
 namespace arc {
 namespace utils {
 
+struct ThreadPoolOptions {
+  // pins worker i to the allowed cpus of numa node i modulo the node count
+  // and prefers the memory of that node, workers failing to do so are left
+  // unpinned
+  bool spread_over_numa_nodes{false};
+};
+
 class ThreadPool {
  public:
 
   static ThreadPool& GetInstance();
+  // must be called before the pool is first used
+  static void SetGlobalOptions(const ThreadPoolOptions& options);
 
   // add new work item to the pool
   template <class F, class... Args>
@@ -101,7 +110,8 @@ class ThreadPool {
   }
 
  private:
-  ThreadPool(size_t);
+  ThreadPool(size_t, const ThreadPoolOptions& options);
+  static void SpreadCurrentWorker(size_t index);
   // need to keep track of threads so we can join them
   std::vector<std::thread> workers_;
   // the task queue
@@ -29,7 +29,10 @@
 #include <arc/coro/eventloop.h>
 #include <arc/coro/eventloop_group.h>
 #include <arc/coro/task.h>
+#include <arc/coro/poller/epoll.h>
+#include <arc/coro/poller/io_uring.h>
 #include <arc/exception/io.h>
+#include <arc/utils/cpu.h>
 
 #include <iostream>
 
@@ -47,8 +50,36 @@ inline EventLoopType operator~(EventLoopType a) {
   return static_cast<EventLoopType>(~static_cast<int>(a));
 }
 
-EventLoop::EventLoop() {
-  poller_ = new Poller();
+namespace {
+thread_local EventLoopOptions local_event_loop_options{};
+thread_local bool is_local_event_loop_created = false;
+thread_local EventLoop* local_event_loop = nullptr;
+}  // namespace
+
+EventLoop::EventLoop()
+    : options_(local_event_loop_options),
+      busy_poll_max_budget_(options_.busy_poll_us * 1000),
+      busy_poll_budget_(busy_poll_max_budget_) {
+  is_local_event_loop_created = true;
+  local_event_loop = this;
+  if (options_.cpu_affinity >= 0) {
+    utils::SetCurrentThreadAffinity({options_.cpu_affinity});
+  }
+  numa_node_ = utils::GetCurrentNumaNode();
+  if (options_.numa_local_memory && numa_node_ >= 0) {
+    utils::SetCurrentThreadPreferredNumaNode(numa_node_);
+  }
+  EventAllocator::SetLocalInstance(&event_allocator_);
+  switch (options_.poller_type) {
+    case PollerType::IO_URING:
+      poller_ = new IOUringPoller(options_.high_resolution_timer);
+      break;
+    case PollerType::EPOLL:
+    default:
+      poller_ = new EpollPoller(options_.high_resolution_timer,
+                                options_.epoll_edge_triggered);
+      break;
+  }
   id_ = EventLoopGroup::GetInstance().RegisterEventLoop(this);
 }
 
@@ -56,11 +87,12 @@ EventLoop::~EventLoop() {
   DeResigerProducer();
   DeResigerConsumer();
   EventLoopGroup::GetInstance().DeRegisterEventLoop(id_);
+  local_event_loop = nullptr;
   delete poller_;
 }
 
 bool EventLoop::IsDone() {
-  return poller_->IsPollerDone() &&
+  return ready_coroutines_.Empty() && poller_->IsPollerDone() &&
          ((event_loop_type_ == EventLoopType::NONE) ||
           (((event_loop_type_ & EventLoopType::PRODUCER) ==
             EventLoopType::PRODUCER) &&
@@ -73,15 +105,142 @@ void EventLoop::InitDo() {
 }
 
 void EventLoop::Do() {
+  timings_.iterations.Add(1);
   // Then we will handle all others
+  int todo_cnt = 0;
+  {
+    detail::ProfileScope scope(Profiled(timings_.wait));
+    todo_cnt = WaitEvents();
+  }
+
+  // consumers publish how long they are busy per iteration for load aware
+  // dispatching
+  std::int64_t busy_start = 0;
+  if (dispatcher_queue_ != nullptr) {
+    busy_start = detail::GetCurrentTime();
+    dispatcher_queue_->SetBusySince(busy_start);
+  }
+  {
+    detail::ProfileScope scope(Profiled(timings_.resume));
+    for (int i = 0; i < todo_cnt; i++) {
+      todo_events_[i]->Resume();
+      delete todo_events_[i];
+    }
+  }
+
+  {
+    detail::ProfileScope scope(Profiled(timings_.trim));
+    Trim();
+  }
+  if (busy_start != 0 && dispatcher_queue_ != nullptr) {
+    std::int64_t lag = detail::GetCurrentTime() - busy_start;
+    loop_lag_ += (lag - loop_lag_) / kLoopLagSmoothingFactor_;
+    dispatcher_queue_->SetLoopLag(loop_lag_);
+    dispatcher_queue_->SetBusySince(0);
+  }
+}
+
+int EventLoop::WaitEvents() {
+  std::int64_t timeout = poller_->GetNextWaitTimeout();
+  if (timeout != 0 && StealCoroutines()) [[unlikely]] {
+    poller_->SetNextTimeNoWait();
+    timeout = 0;
+  }
+  if (timeout == 0 || dispatcher_queue_ == nullptr) [[likely]] {
+    return PollEvents(timeout);
+  }
+
+  // producers only write to the eventfd of a sleeping consumer
+  if (!dispatcher_queue_->Sleep()) {
+    poller_->SetNextTimeNoWait();
+    return PollEvents(0);
+  }
+  // an idle loop does not lag behind whatever it ran before
+  loop_lag_ = 0;
+  dispatcher_queue_->SetLoopLag(0);
+  int todo_cnt = PollEvents(timeout);
+  dispatcher_queue_->WakeUp();
+  return todo_cnt;
+}
+
+int EventLoop::PollEvents(std::int64_t timeout) {
+  if (busy_poll_max_budget_ == 0 || timeout == 0) [[likely]] {
+    return poller_->WaitEvents(todo_events_);
+  }
+
+  std::int64_t now = detail::GetCurrentTime();
+  if (busy_poll_budget_ > 0) {
+    std::int64_t spin_start = now;
+    std::int64_t spin_end =
+        spin_start +
+        (timeout < 0 ? busy_poll_budget_ : std::min(busy_poll_budget_, timeout));
+    poller_->SetNextTimeNoWait();
+    do {
+      int todo_cnt = poller_->WaitEvents(todo_events_);
+      if (todo_cnt > 0 || HasCoroutinesToConsume()) {
+        return todo_cnt;
+      }
+      now = detail::GetCurrentTime();
+    } while (now < spin_end);
+    // nothing came while spinning, spin less next time
+    busy_poll_budget_ /= 2;
+    if (timeout > 0) {
+      timeout = std::max(std::int64_t{0}, timeout - (now - spin_start));
+    }
+  }
+
+  poller_->SetNextWaitTimeout(timeout);
   int todo_cnt = poller_->WaitEvents(todo_events_);
+  std::int64_t slept = detail::GetCurrentTime() - now;
+  if (todo_cnt > 0 && slept < busy_poll_max_budget_) {
+    // events came soon after the loop went to sleep, spin longer next time
+    busy_poll_budget_ = std::min(busy_poll_max_budget_,
+                                 std::max(busy_poll_budget_, slept) * 2);
+  }
+  return todo_cnt;
+}
 
-  for (int i = 0; i < todo_cnt; i++) {
-    todo_events_[i]->Resume();
-    delete todo_events_[i];
+bool EventLoop::HasCoroutinesToConsume() const {
+  if (dispatcher_queue_ == nullptr) {
+    return false;
   }
+  return dispatcher_queue_->GetRemainedItemsCount() > 0 ||
+         (dispatcher_queue_->IsWorkStealing() &&
+          dispatcher_queue_->GetStealableDeque().GetSize() > 0);
+}
 
-  Trim();
+bool EventLoop::StealCoroutines() {
+  if (dispatcher_queue_ == nullptr || !dispatcher_queue_->IsWorkStealing()) {
+    return false;
+  }
+  // become idle first so that no coroutine left by a busy consumer after the
+  // steal below is missed
+  global_dispatcher_->SetIdle(dispatcher_queue_, true);
+  if (global_dispatcher_->Steal(register_id_) > 0) {
+    global_dispatcher_->SetIdle(dispatcher_queue_, false);
+    return true;
+  }
+  return false;
+}
+
+EventLoopProfile EventLoop::GetProfile() const {
+  EventLoopProfile profile{};
+  profile.iterations = timings_.iterations.Get();
+  auto& counters = poller_->GetCounters();
+  profile.io_events = counters.io_events.Get();
+  profile.time_events = counters.time_events.Get();
+  profile.user_events = counters.user_events.Get();
+  profile.bound_events = counters.bound_events.Get();
+  profile.poller_control_calls = counters.control_calls.Get();
+  profile.wait = timings_.wait.Snapshot();
+  profile.resume = timings_.resume.Snapshot();
+  profile.trim = timings_.trim.Snapshot();
+  profile.consume_coroutine = timings_.consume_coroutine.Snapshot();
+  profile.produce_coroutine = timings_.produce_coroutine.Snapshot();
+  profile.trim_io_events = timings_.trim_io_events.Snapshot();
+  profile.trim_time_events = timings_.trim_time_events.Snapshot();
+  profile.clean_up_coroutines = timings_.clean_up_coroutines.Snapshot();
+  return profile;
 }
 
 EventLoop& EventLoop::GetLocalInstance() {
@@ -89,6 +248,48 @@ EventLoop& EventLoop::GetLocalInstance() {
   return loop;
 }
 
+void EventLoop::ResetLocalIOInterest(int fd) {
+  if (local_event_loop != nullptr) {
+    local_event_loop->poller_->ResetIOInterest(fd);
+  }
+}
+
+void EventLoop::SetLocalOptions(const EventLoopOptions& options) {
+  if (is_local_event_loop_created) {
+    throw arc::exception::detail::ExceptionBase(
+        "Event loop options must be set before the event loop is created");
+  }
+  local_event_loop_options = options;
+}
+
+bool EventLoop::TriggerUserEvent(EventID event_id) {
+  if (local_event_loop != this) {
+    return poller_->TriggerUserEvent(event_id);
+  }
+  auto event = poller_->PopUserEvent(event_id);
+  if (event == nullptr) [[unlikely]] {
+    return false;
+  }
+  ready_coroutines_.PushBack({nullptr, event});
+  return true;
+}
+
+void EventLoop::ResumeReadyCoroutines() {
+  // coroutines which become ready meanwhile wait for the next iteration, so
+  // a yielding coroutine does not starve the poller
+  std::size_t count = ready_coroutines_.Size();
+  for (std::size_t i = 0; i < count; i++) {
+    auto ready = ready_coroutines_.Front();
+    ready_coroutines_.PopFront(1);
+    if (ready.event != nullptr) {
+      ready.event->Resume();
+      delete ready.event;
+    } else {
+      ready.handle.resume();
+    }
+  }
+}
+
 void EventLoop::AddToCleanUpCoroutine(std::coroutine_handle<> handle) {
   to_clean_up_handles_.push_back(handle);
 }
@@ -102,35 +303,43 @@ void EventLoop::CleanUpFinishedCoroutines() {
 
 void EventLoop::Dispatch(arc::coro::Task<void>&& task) {
   task.SetNeedClean(true);
-  to_randomly_dispatched_coroutines_.push_back(task.GetCoroutine());
+  to_randomly_dispatched_coroutines_.PushBack(task.GetCoroutine());
   to_dispatched_coroutines_count_++;
 }
 
 void EventLoop::DispatchTo(arc::coro::Task<void>&& task,
                            EventLoopWakeUpHandle consumer_id) {
   task.SetNeedClean(true);
-  if (to_dispatched_coroutines_with_dests_.find(consumer_id) ==
-      to_dispatched_coroutines_with_dests_.end()) {
-    to_dispatched_coroutines_with_dests_[consumer_id] =
-        std::list<std::coroutine_handle<void>>();
-  }
-  to_dispatched_coroutines_with_dests_[consumer_id].push_back(
+  to_dispatched_coroutines_with_dests_[consumer_id].PushBack(
       task.GetCoroutine());
   to_dispatched_coroutines_count_++;
 }
 
+void EventLoop::DispatchByKey(std::uint64_t key,
+                              arc::coro::Task<void>&& task) {
+  task.SetNeedClean(true);
+  to_key_dispatched_coroutines_.PushBack({key, task.GetCoroutine()});
+  to_dispatched_coroutines_count_++;
+}
+
 void EventLoop::ResigerConsumer() {
   event_loop_type_ = EventLoopType::CONSUMER | event_loop_type_;
   global_dispatcher_ = &CoroutineDispatcher::GetInstance();
   register_id_ = poller_->Register();
-  dispatcher_queue_ = global_dispatcher_->Register(register_id_);
+  dispatcher_queue_ = global_dispatcher_->Register(
+      register_id_, options_.work_stealing, numa_node_);
 }
 
 void EventLoop::DeResigerConsumer() {
   if ((event_loop_type_ & EventLoopType::CONSUMER) == EventLoopType::CONSUMER) {
     event_loop_type_ = (event_loop_type_ & (~EventLoopType::CONSUMER));
     ConsumeCoroutine();
-    global_dispatcher_->DeRegister(register_id_);
+    if (dispatcher_queue_->IsWorkStealing()) {
+      for (auto& coro : dispatcher_queue_->GetStealableDeque().PopAll()) {
+        coro.resume();
+      }
+    }
+    ResumeSpaceWaiters(global_dispatcher_->DeRegister(register_id_));
     poller_->DeRegister();
     dispatcher_queue_ = nullptr;
     register_id_ = -1;
@@ -151,31 +360,100 @@ void EventLoop::DeResigerProducer() {
 
 void EventLoop::Trim() {
   if ((EventLoopType::CONSUMER & event_loop_type_) == EventLoopType::CONSUMER) {
+    detail::ProfileScope scope(Profiled(timings_.consume_coroutine));
     ConsumeCoroutine();
   }
   if ((EventLoopType::PRODUCER & event_loop_type_) == EventLoopType::PRODUCER) {
+    detail::ProfileScope scope(Profiled(timings_.produce_coroutine));
     ProduceCoroutine();
   }
+  // after producing, so coroutines dispatched before a yield are sent first,
+  // and before trimming, so the io they wait for is registered in this round
+  ResumeReadyCoroutines();
 
-  poller_->TrimIOEvents();
-  poller_->TrimTimeEvents();
+  {
+    detail::ProfileScope scope(Profiled(timings_.trim_io_events));
+    poller_->TrimIOEvents();
+  }
+  {
+    detail::ProfileScope scope(Profiled(timings_.trim_time_events));
+    poller_->TrimTimeEvents();
+  }
   poller_->TrimUserEvents();
 
-  CleanUpFinishedCoroutines();
+  {
+    detail::ProfileScope scope(Profiled(timings_.clean_up_coroutines));
+    CleanUpFinishedCoroutines();
+  }
 
-  if (to_dispatched_coroutines_count_ != 0) [[unlikely]] {
+  if (to_dispatched_coroutines_count_ != 0 || !ready_coroutines_.Empty())
+      [[unlikely]] {
     poller_->SetNextTimeNoWait();
   }
+  if (dispatcher_queue_ != nullptr && dispatcher_queue_->IsWorkStealing() &&
+      dispatcher_queue_->GetStealableDeque().GetSize() > 0) [[unlikely]] {
+    poller_->SetNextTimeNoWait();
+    global_dispatcher_->WakeUpIdleConsumer();
+  }
 }
 
 void EventLoop::ConsumeCoroutine() {
-  auto triggered_count = dispatcher_queue_->GetRemainedItemsCount();
-  if (triggered_count == 0) {
+  // only what is there now, coroutines dispatched by the resumed ones wait for
+  // the next iteration
+  int triggered_count = dispatcher_queue_->GetRemainedItemsCount();
+  while (triggered_count > 0) {
+    // on the stack as resumed coroutines may deregister the consumer, which
+    // consumes again
+    std::coroutine_handle<> coroutines[kMaxDequeuedCoroutineNum_];
+    int count = dispatcher_queue_->DequeBulk(
+        coroutines, std::min(triggered_count, kMaxDequeuedCoroutineNum_));
+    if (count == 0) [[unlikely]] {
+      // not visible yet, the consumer does not sleep until it is taken
+      break;
+    }
+    triggered_count -= count;
+    if (dispatcher_queue_->HasSpaceWaiters()) [[unlikely]] {
+      ResumeSpaceWaiters(dispatcher_queue_->TakeSpaceWaiters());
+    }
+    for (int i = 0; i < count; i++) {
+      if (dispatcher_queue_ != nullptr) [[likely]] {
+        dispatcher_queue_->SetDequeuedCount(count - i);
+      }
+      coroutines[i].resume();
+    }
+    if (dispatcher_queue_ == nullptr) [[unlikely]] {
+      return;
+    }
+    dispatcher_queue_->SetDequeuedCount(0);
+  }
+  if (!dispatcher_queue_->IsWorkStealing()) [[likely]] {
     return;
   }
-  auto coroutines = dispatcher_queue_->DequeAll(triggered_count);
-  for (auto& coro : coroutines) {
-    coro.resume();
+  global_dispatcher_->SetIdle(dispatcher_queue_, false);
+  // leave the rest in the deque so that idle consumers can steal them
+  auto& deque = dispatcher_queue_->GetStealableDeque();
+  std::coroutine_handle<> coroutines[kMaxConsumableCoroutineNum_];
+  std::size_t count = deque.PopFront(coroutines, kMaxConsumableCoroutineNum_);
+  for (std::size_t i = 0; i < count; i++) {
+    coroutines[i].resume();
+  }
+}
+
+void EventLoop::ResumeSpaceWaiters(const std::vector<SpaceWaiter>& waiters) {
+  if (waiters.empty()) {
+    return;
+  }
+  auto& group = EventLoopGroup::GetInstance();
+  std::lock_guard guard(group.EventLoopGroupLock());
+  for (auto& waiter : waiters) {
+    if (waiter.semaphore != nullptr) {
+      waiter.semaphore->release();
+      continue;
+    }
+    auto loop = group.GetEventLoopNoLock(waiter.event_loop_id);
+    if (loop) {
+      loop->TriggerUserEvent(waiter.event_id);
+    }
   }
 }
 
@@ -183,50 +461,50 @@ void EventLoop::ProduceCoroutine() {
   if (to_dispatched_coroutines_count_ == 0) {
     return;
   }
-  if (!to_randomly_dispatched_coroutines_.empty()) {
-    if (!global_dispatcher_->EnqueueAllToAny(
-            to_randomly_dispatched_coroutines_.begin(),
-            to_randomly_dispatched_coroutines_.size())) {
-      auto itr = to_randomly_dispatched_coroutines_.begin();
-      while (itr != to_randomly_dispatched_coroutines_.end()) {
-        if (global_dispatcher_->EnqueueToAny(std::move(*itr))) {
-          itr = to_randomly_dispatched_coroutines_.erase(itr);
-          to_dispatched_coroutines_count_--;
-        } else {
-          break;
-        }
+  auto policy = options_.dispatch_policy;
+  int numa_node = GetDispatchNumaNode();
+  while (!to_randomly_dispatched_coroutines_.Empty()) {
+    auto segment = to_randomly_dispatched_coroutines_.FrontSegment();
+    int count = segment.size();
+    if (!global_dispatcher_->EnqueueAllToAny(segment.begin(), count, policy,
+                                             numa_node)) {
+      // the picked consumer is full, try the others one by one
+      if (!global_dispatcher_->EnqueueToAny(
+              std::move(to_randomly_dispatched_coroutines_.Front()), policy,
+              numa_node)) {
+        break;
       }
-    } else {
-      to_dispatched_coroutines_count_ -=
-          to_randomly_dispatched_coroutines_.size();
-      to_randomly_dispatched_coroutines_.clear();
+      count = 1;
+    }
+    to_randomly_dispatched_coroutines_.PopFront(count);
+    to_dispatched_coroutines_count_ -= count;
+  }
+
+  // stops at the first full queue to keep the order of each key
+  while (!to_key_dispatched_coroutines_.Empty()) {
+    auto& [key, handle] = to_key_dispatched_coroutines_.Front();
+    if (!global_dispatcher_->EnqueueToKey(key, handle)) {
+      break;
     }
+    to_key_dispatched_coroutines_.PopFront();
+    to_dispatched_coroutines_count_--;
   }
-  auto map_itr = to_dispatched_coroutines_with_dests_.begin();
-  while (map_itr != to_dispatched_coroutines_with_dests_.end()) {
-    assert(!map_itr->second.empty());
-    if (!global_dispatcher_->EnqueueAllToSpecific(
-            map_itr->first, map_itr->second.begin(), map_itr->second.size())) {
-      auto itr = map_itr->second.begin();
-      while (itr != map_itr->second.end()) {
-        if (global_dispatcher_->EnqueueToAny(std::move(*itr))) {
-          itr = map_itr->second.erase(itr);
-          to_dispatched_coroutines_count_--;
-        } else {
+
+  for (auto& [consumer_id, coroutines] : to_dispatched_coroutines_with_dests_) {
+    while (!coroutines.Empty()) {
+      auto segment = coroutines.FrontSegment();
+      int count = segment.size();
+      if (!global_dispatcher_->EnqueueAllToSpecific(consumer_id,
+                                                    segment.begin(), count)) {
+        // full or being deregistered, try the others one by one
+        if (!global_dispatcher_->EnqueueToAny(std::move(coroutines.Front()),
+                                              policy, numa_node)) {
           break;
         }
+        count = 1;
       }
-    } else {
-      to_dispatched_coroutines_count_ -= map_itr->second.size();
-      map_itr->second.clear();
-    }
-
-    if (map_itr->second.empty()) {
-      map_itr = to_dispatched_coroutines_with_dests_.erase(map_itr);
-    } else {
-      map_itr++;
+      coroutines.PopFront(count);
+      to_dispatched_coroutines_count_ -= count;
     }
   }
-
-  return;
 }
@@ -28,49 +28,44 @@
 
 #include <arc/coro/poller/epoll.h>
 #include <arc/exception/io.h>
-#include <sys/eventfd.h>
-
-#include <iostream>
+#include <sys/syscall.h>
+#include <sys/timerfd.h>
 
 using namespace arc;
 using namespace arc::coro;
 
-Poller::Poller() {
+EpollPoller::EpollPoller(bool is_high_resolution_timer, bool is_edge_triggered)
+    : Poller(is_high_resolution_timer), is_edge_triggered_(is_edge_triggered) {
   fd_ = epoll_create1(0);
   if (fd_ < 0) {
     throw arc::exception::IOException("Epoll Creation Error");
   }
-  user_event_fd_ = eventfd(0, EFD_NONBLOCK);
-  if (user_event_fd_ < 0) {
-    throw arc::exception::IOException("EventFd Creation Error");
-  }
-  interesting_fds_.reserve(kMaxFdInArray_);
-  std::fill(std::begin(io_prev_events_), std::end(io_prev_events_), 0);
 }
 
-Poller::~Poller() {
-  std::lock_guard guard(poller_lock_);
-  if (user_event_fd_ >= 0) {
-    close(user_event_fd_);
+EpollPoller::~EpollPoller() {
+  if (timer_fd_ >= 0) {
+    close(timer_fd_);
   }
 }
 
-int Poller::WaitEvents(coro::EventBase** todo_events) {
-  int event_cnt =
-      epoll_wait(fd_, events_, kMaxEventsSizePerWait, next_wait_timeout_);
+int EpollPoller::WaitIOEvents(coro::EventBase** todo_events,
+                              bool* is_user_event_triggered) {
+  if (is_edge_triggered_) {
+    return WaitIOEventsEdgeTriggered(todo_events, is_user_event_triggered);
+  }
+  int event_cnt = Wait(next_wait_timeout_);
   int todo_cnt = 0;
 
-  bool is_user_event_triggered = false;
-  bool is_dispatched_triggered = false;
-
-  // io events
   for (int i = 0; i < event_cnt; i++) {
     int fd = events_[i].data.fd;
     if (fd == user_event_fd_) {
-      is_user_event_triggered = true;
+      *is_user_event_triggered = true;
       assert(events_[i].events & EPOLLIN);
       continue;
     }
+    if (IsTimerFd(fd)) [[unlikely]] {
+      continue;
+    }
     int event_type = events_[i].events;
     if (event_type & EPOLLIN) {
       todo_events[todo_cnt] = PopIOEvent(fd, io::IOType::READ);
@@ -89,194 +84,31 @@ int Poller::WaitEvents(coro::EventBase** todo_events) {
           std::to_string(event_type));
     }
   }
-
-  // time events
-  if (!time_events_.empty() && todo_cnt < kMaxEventsSizePerWait) {
-    std::int64_t current_time =
-        std::chrono::duration_cast<std::chrono::milliseconds>(
-            (std::chrono::steady_clock::now()).time_since_epoch())
-            .count();
-
-    while (!time_events_.empty()) {
-      if (!time_events_.top()->IsValid()) {
-        delete time_events_.top();
-        time_events_.pop();
-        continue;
-      }
-      if ((todo_cnt >= kMaxEventsSizePerWait) ||
-          (current_time < time_events_.top()->GetWakeupTime())) {
-        break;
-      }
-      auto top_time_event = time_events_.top();
-      if (top_time_event->IsTrigger()) [[unlikely]] {
-        TriggerBoundEvent(
-            static_cast<TimeoutEvent*>(top_time_event)->GetBountEventID(),
-            static_cast<TimeoutEvent*>(top_time_event));
-        time_events_.pop();
-      } else {
-        todo_events[todo_cnt] = top_time_event;
-        self_triggered_event_ids_[todo_cnt] =
-            todo_events[todo_cnt]->GetEventID();
-        time_events_.pop();
-        todo_cnt++;
-      }
-    }
-  }
-
-  std::lock_guard guard(poller_lock_);
-  // user events or dispatched events
-  bool need_to_write_again = false;
-  std::uint64_t event_read = 0;
-  if (is_user_event_triggered) {
-    int read_bytes = read(user_event_fd_, &event_read, sizeof(event_read));
-    if (read_bytes != sizeof(event_read)) {
-      throw arc::exception::IOException(
-          "Read user event or dispatched event error");
-    }
-
-    // check triggered user event
-    auto triggered_event_itr = triggered_user_events_.begin();
-    while (triggered_event_itr != triggered_user_events_.end()) {
-      if (todo_cnt < kMaxEventsSizePerWait) {
-        todo_events[todo_cnt] = *triggered_event_itr;
-        self_triggered_event_ids_[todo_cnt] =
-            todo_events[todo_cnt]->GetEventID();
-        user_events_.erase(todo_events[todo_cnt]->GetEventID());
-        todo_cnt++;
-        triggered_event_itr = triggered_user_events_.erase(triggered_event_itr);
-      } else {
-        need_to_write_again = true;
-        break;
-      }
-    }
-  }
-
-  // remove triggered bound events
-  RemoveBoundEvent(todo_cnt);
-
-  // check triggered bound event
-  auto triggered_bound_event_itr = triggered_bound_events_.begin();
-  while (triggered_bound_event_itr != triggered_bound_events_.end()) {
-    if (todo_cnt < kMaxEventsSizePerWait) {
-      auto triggered_bound_event = PopBoundEvent(*triggered_bound_event_itr);
-      if (triggered_bound_event) {
-        triggered_bound_event->SetInterrupted(true);
-        todo_events[todo_cnt] = triggered_bound_event;
-        todo_cnt++;
-      }
-    } else {
-      need_to_write_again = true;
-      break;
-    }
-    delete *triggered_bound_event_itr;
-    triggered_bound_event_itr =
-        triggered_bound_events_.erase(triggered_bound_event_itr);
-  }
-
-  // re-write again if todo count supercede the max allowed events
-  if (need_to_write_again) {
-    // need to do it in the next wait routine
-    event_read = 1;
-    int wrote = write(user_event_fd_, &event_read, sizeof(event_read));
-    if (wrote != sizeof(event_read)) {
-      throw arc::exception::IOException(
-          "Write user event or dispatched event in epoll wait error");
-    }
-  }
-
   return todo_cnt;
 }
 
-void Poller::AddIOEvent(coro::IOEvent* event) {
-  event->SetEventID(max_event_id_.fetch_add(1, std::memory_order::relaxed));
-  auto target_fd = event->GetFd();
-  io::IOType event_type = event->GetIOType();
-
-  total_io_events_++;
-  int should_add_event = (event_type == io::IOType::READ ? EPOLLIN : EPOLLOUT);
-
-  std::deque<arc::coro::IOEvent*>* to_be_pushed_queue = nullptr;
-  if (target_fd < kMaxFdInArray_) [[likely]] {
-    to_be_pushed_queue = &io_events_[target_fd][static_cast<int>(event_type)];
-  } else [[unlikely]] {
-    if (extra_io_events_.find(target_fd) == extra_io_events_.end()) {
-      extra_io_events_[target_fd] = std::vector<std::deque<coro::IOEvent*>>{
-          2, std::deque<coro::IOEvent*>{}};
+void EpollPoller::RemoveIOInterest(int target_fd) {
+  if (is_edge_triggered_) {
+    auto& state = GetEdgeState(target_fd);
+    bool is_registered = (state & REGISTERED);
+    state = 0;
+    if (is_registered && ControlIO(EPOLL_CTL_DEL, target_fd, nullptr) != 0)
+        [[unlikely]] {
+      throw arc::exception::IOException(
+          "Epoll Error When Deleting All IO Events of FD: " +
+          std::to_string(target_fd));
     }
-    to_be_pushed_queue =
-        &extra_io_events_[target_fd][static_cast<int>(event_type)];
-  }
-
-  interesting_fds_.insert(target_fd);
-  to_be_pushed_queue->push_back(event);
-}
-
-void Poller::AddTimeEvent(coro::TimeEvent* event) {
-  event->SetEventID(max_event_id_.fetch_add(1, std::memory_order::relaxed));
-  time_events_.push(event);
-}
-
-void Poller::AddUserEvent(coro::UserEvent* event) {
-  std::lock_guard guard(poller_lock_);
-  event->SetEventID(max_event_id_.fetch_add(1, std::memory_order::relaxed));
-  pending_user_events_.push_back(event);
-  event->SetIterator(std::prev(pending_user_events_.end()));
-  user_events_.insert({event->GetEventID(), event});
-}
-
-void Poller::AddBoundEvent(coro::BoundEvent* event) {
-  std::lock_guard guard(poller_lock_);
-  pending_bound_events_.push_back(event);
-  auto itr = std::prev(pending_bound_events_.end());
-  event_pending_bound_token_map_[event->GetBountEventID()] = itr;
-  event->SetIterator(itr);
-  if (event->GetTriggerType() == detail::TriggerType::TIME_EVENT) {
-    time_events_.push(static_cast<TimeoutEvent*>(event));
+    return;
   }
-}
-
-void Poller::RemoveAllIOEvents(int target_fd) {
-  bool need_epoll_ctl = false;
 
-  std::deque<arc::coro::IOEvent*>* read_queue = nullptr;
-  std::deque<arc::coro::IOEvent*>* write_queue = nullptr;
-  if (target_fd < kMaxFdInArray_) [[likely]] {
-    read_queue = &io_events_[target_fd][static_cast<int>(io::IOType::READ)];
-    write_queue = &io_events_[target_fd][static_cast<int>(io::IOType::WRITE)];
+  int prev_event = 0;
+  if (static_cast<std::size_t>(target_fd) < io_prev_events_.size()) {
+    prev_event = io_prev_events_[target_fd];
     io_prev_events_[target_fd] = 0;
-  } else [[unlikely]] {
-    if (extra_io_events_.find(target_fd) == extra_io_events_.end()) {
-      return;
-    }
-    read_queue =
-        &extra_io_events_[target_fd][static_cast<int>(io::IOType::READ)];
-    write_queue =
-        &extra_io_events_[target_fd][static_cast<int>(io::IOType::WRITE)];
-    extra_io_prev_events_.erase(0);
-  }
-  auto itr = read_queue->begin();
-  while (itr != read_queue->end()) {
-    need_epoll_ctl = true;
-    (*itr)->Resume();
-    delete (*itr);
-    itr = read_queue->erase(itr);
-    total_io_events_--;
-  }
-  itr = write_queue->begin();
-  while (itr != write_queue->end()) {
-    need_epoll_ctl = true;
-    (*itr)->Resume();
-    delete (*itr);
-    itr = write_queue->erase(itr);
-    total_io_events_--;
-  }
-
-  if (interesting_fds_.find(target_fd) != interesting_fds_.end()) {
-    interesting_fds_.erase(target_fd);
   }
 
-  if (need_epoll_ctl) {
-    int epoll_ret = epoll_ctl(fd_, EPOLL_CTL_DEL, target_fd, nullptr);
+  if (prev_event != 0) {
+    int epoll_ret = ControlIO(EPOLL_CTL_DEL, target_fd, nullptr);
     if (epoll_ret != 0) [[unlikely]] {
       throw arc::exception::IOException(
           "Epoll Error When Deleting All IO Events of FD: " +
@@ -285,19 +117,30 @@ void Poller::RemoveAllIOEvents(int target_fd) {
   }
 }
 
-void Poller::TrimIOEvents() {
+void EpollPoller::ResetIOInterest(int target_fd) {
+  if (target_fd < 0) {
+    return;
+  }
+  // the kernel drops the registration once the old file is closed
+  if (!is_edge_triggered_) {
+    GetFdSlot(io_prev_events_, target_fd) = 0;
+    return;
+  }
+  // the fd may still be queued in ready_fds_ though
+  auto& state = GetEdgeState(target_fd);
+  state &= PENDING;
+}
+
+void EpollPoller::TrimIOEvents() {
+  if (is_edge_triggered_) {
+    TrimIOEventsEdgeTriggered();
+    return;
+  }
   for (int fd : interesting_fds_) {
-    int prev_event = 0;
     int cur_event = GetExistingIOEvent(fd);
-    if (fd < kMaxFdInArray_) {
-      prev_event = io_prev_events_[fd];
-      io_prev_events_[fd] = cur_event;
-    } else {
-      if (extra_io_prev_events_.find(fd) != extra_io_prev_events_.end()) {
-        prev_event = extra_io_prev_events_[fd];
-      }
-      extra_io_prev_events_[fd] = cur_event;
-    }
+    int& prev_event_slot = GetFdSlot(io_prev_events_, fd);
+    int prev_event = prev_event_slot;
+    prev_event_slot = cur_event;
 
     if (cur_event == prev_event) {
       continue;
@@ -308,206 +151,245 @@ void Poller::TrimIOEvents() {
     epoll_event e_event{};
     e_event.events = cur_event;
     e_event.data.fd = fd;
-    int epoll_ret = epoll_ctl(fd_, op, fd, &e_event);
+    int epoll_ret = ControlIO(op, fd, &e_event);
     if (epoll_ret != 0) {
       throw arc::exception::IOException("Epoll Error When Trimming IO Events");
     }
   }
 }
 
-void Poller::TrimUserEvents() {
-  std::lock_guard guard(poller_lock_);
-  bool should_add_epoll = !pending_user_events_.empty() ||
-                          !triggered_user_events_.empty() ||
-                          is_dispatcher_registered_;
-  if (is_event_fd_added_ == should_add_epoll) {
-    return;
-  }
-  int op = should_add_epoll ? EPOLL_CTL_ADD : EPOLL_CTL_DEL;
+void EpollPoller::SetUserEventInterest(bool is_interested) {
+  int op = is_interested ? EPOLL_CTL_ADD : EPOLL_CTL_DEL;
   epoll_event e_event{};
   e_event.events = EPOLLIN;
   e_event.data.fd = user_event_fd_;
-  int epoll_ret = epoll_ctl(fd_, op, user_event_fd_, &e_event);
+  int epoll_ret = Control(op, user_event_fd_, &e_event);
   if (epoll_ret != 0) {
     throw arc::exception::IOException("Epoll Error When Trimming User Events");
   }
-  is_event_fd_added_ = should_add_epoll;
 }
 
-void Poller::TrimTimeEvents() {
-  // first pop up invalid time event (e.g. triggered timeout event)
-  while (!time_events_.empty() && !time_events_.top()->IsValid()) {
-    delete time_events_.top();
-    time_events_.pop();
+int EpollPoller::GetExistingIOEvent(int fd) {
+  int cur = 0;
+  if (HasIOEvent(fd, io::IOType::READ)) {
+    cur |= EPOLLIN;
   }
-  if (time_events_.empty()) {
-    next_wait_timeout_ = -1;  // wait infinitely if no time event
-    return;
+  if (HasIOEvent(fd, io::IOType::WRITE)) {
+    cur |= EPOLLOUT;
   }
-  auto top_event = time_events_.top();
-  std::int64_t current_time =
-      std::chrono::duration_cast<std::chrono::milliseconds>(
-          (std::chrono::steady_clock::now()).time_since_epoch())
-          .count();
-  next_wait_timeout_ =
-      std::max((std::int64_t)0, top_event->GetWakeupTime() - current_time);
+  return cur;
 }
 
-bool Poller::TriggerUserEvent(EventID event_id) {
-  std::lock_guard guard(poller_lock_);
-  auto event_itr = user_events_.find(event_id);
-  if (event_itr == user_events_.end()) [[unlikely]] {
-    return false;
+int EpollPoller::WaitIOEventsEdgeTriggered(coro::EventBase** todo_events,
+                                           bool* is_user_event_triggered) {
+  // do not block if some waiting fds are already known to be ready
+  int event_cnt = Wait(ready_fds_.empty() ? next_wait_timeout_ : 0);
+
+  for (int i = 0; i < event_cnt; i++) {
+    int fd = events_[i].data.fd;
+    if (fd == user_event_fd_) {
+      *is_user_event_triggered = true;
+      continue;
+    }
+    if (IsTimerFd(fd)) [[unlikely]] {
+      continue;
+    }
+    int event_type = events_[i].events;
+    auto& state = GetEdgeState(fd);
+    if (event_type & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+      state |= READ_READY;
+    }
+    if (event_type & (EPOLLOUT | EPOLLHUP | EPOLLERR)) {
+      state |= WRITE_READY;
+    }
+    if ((state & PENDING) == 0) {
+      state |= PENDING;
+      ready_fds_.push_back(fd);
+    }
   }
-  auto event = event_itr->second;
-  pending_user_events_.erase(event->GetIterator());
-  triggered_user_events_.push_back(event);
 
-  // trigger self
-  std::uint64_t i = 1;
-  if (write(user_event_fd_, &i, sizeof(i)) < 0) {
-    throw arc::exception::IOException("Trigger User Event Error");
+  int todo_cnt = 0;
+  std::size_t handled_cnt = 0;
+  for (; handled_cnt < ready_fds_.size(); handled_cnt++) {
+    if (todo_cnt >= kMaxEventsSizePerWait) {
+      break;
+    }
+    int fd = ready_fds_[handled_cnt];
+    auto& state = GetEdgeState(fd);
+    state &= ~PENDING;
+    if (state & READ_READY) {
+      todo_cnt = PopReadyIOEvents(fd, io::IOType::READ, todo_events, todo_cnt);
+    }
+    if (state & WRITE_READY) {
+      todo_cnt = PopReadyIOEvents(fd, io::IOType::WRITE, todo_events, todo_cnt);
+    }
   }
-  return true;
+  ready_fds_.erase(ready_fds_.begin(), ready_fds_.begin() + handled_cnt);
+  return todo_cnt;
 }
 
-void Poller::TriggerBoundEvent(EventID bound_event_id,
-                               coro::BoundEvent* event) {
-  std::lock_guard guard(poller_lock_);
-  auto event_pending_bound_token_map_itr =
-      event_pending_bound_token_map_.find(bound_event_id);
-  if (event_pending_bound_token_map_itr ==
-      event_pending_bound_token_map_.end()) {
-    return;
+int EpollPoller::PopReadyIOEvents(int fd, io::IOType event_type,
+                                  coro::EventBase** todo_events,
+                                  int todo_cnt) {
+  auto& state = GetEdgeState(fd);
+  std::uint8_t ready_flag =
+      (event_type == io::IOType::READ ? READ_READY : WRITE_READY);
+  std::uint8_t rearm_flag =
+      (event_type == io::IOType::READ ? READ_REARM : WRITE_REARM);
+  while (HasIOEvent(fd, event_type)) {
+    if (todo_cnt >= kMaxEventsSizePerWait) [[unlikely]] {
+      // leave it to the next wait
+      if ((state & PENDING) == 0) {
+        state |= PENDING;
+        ready_fds_.push_back(fd);
+      }
+      break;
+    }
+    auto event = FrontIOEvent(fd, event_type);
+    if (event->HasTryIO()) {
+      if (!event->TryIO()) {
+        state &= ~ready_flag;
+        break;
+      }
+    } else if (event->IsDrainingFd()) {
+      // the kernel reports a new edge once the fd has been drained
+      state &= ~ready_flag;
+    } else {
+      // it is unknown whether this io drains the fd, so the readiness is
+      // dropped and re-checked by the kernel when the next io event comes
+      state &= ~ready_flag;
+      state |= rearm_flag;
+    }
+    todo_events[todo_cnt] = PopIOEvent(fd, event_type);
+    self_triggered_event_ids_[todo_cnt] = todo_events[todo_cnt]->GetEventID();
+    todo_cnt++;
+    if ((state & ready_flag) == 0) {
+      break;
+    }
   }
-  pending_bound_events_.erase(event->GetIterator());
-  triggered_bound_events_.push_back(event);
-  event_pending_bound_token_map_.erase(event_pending_bound_token_map_itr);
+  return todo_cnt;
+}
 
-  // trigger self
-  std::uint64_t i = 1;
-  if (write(user_event_fd_, &i, sizeof(i)) < 0) {
-    throw arc::exception::IOException("Trigger Bound Event Error");
+void EpollPoller::TrimIOEventsEdgeTriggered() {
+  for (int fd : interesting_fds_) {
+    bool has_read = HasIOEvent(fd, io::IOType::READ);
+    bool has_write = HasIOEvent(fd, io::IOType::WRITE);
+    if (!has_read && !has_write) {
+      continue;
+    }
+    auto& state = GetEdgeState(fd);
+    int op = -1;
+    if ((state & REGISTERED) == 0) {
+      op = EPOLL_CTL_ADD;
+      state = REGISTERED;
+    } else if ((has_read && (state & READ_REARM)) ||
+               (has_write && (state & WRITE_REARM))) {
+      // modifying the registration makes the kernel report it again if the
+      // fd is still ready
+      op = EPOLL_CTL_MOD;
+      state &= ~(READ_REARM | WRITE_REARM);
+    }
+    if (op >= 0) {
+      epoll_event e_event{};
+      e_event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+      e_event.data.fd = fd;
+      if (ControlIO(op, fd, &e_event) != 0) {
+        throw arc::exception::IOException(
+            "Epoll Error When Trimming IO Events");
+      }
+    }
+    if (((has_read && (state & READ_READY)) ||
+         (has_write && (state & WRITE_READY))) &&
+        (state & PENDING) == 0) {
+      state |= PENDING;
+      ready_fds_.push_back(fd);
+    }
   }
+  // registrations never change unless new io events come
+  interesting_fds_.clear();
 }
 
-int Poller::Register() {
-  std::lock_guard guard(poller_lock_);
-  is_dispatcher_registered_ = true;
-  return user_event_fd_;
+std::uint8_t& EpollPoller::GetEdgeState(int fd) {
+  return GetFdSlot(io_edge_states_, fd);
 }
 
-void Poller::DeRegister() {
-  std::lock_guard guard(poller_lock_);
-  is_dispatcher_registered_ = false;
-}
+int EpollPoller::Wait(std::int64_t timeout) {
+  if (!is_high_resolution_timer_ || timeout <= 0) {
+    // round up to not wake up before the next time event expires
+    int timeout_ms =
+        timeout <= 0 ? static_cast<int>(timeout)
+                     : static_cast<int>((timeout + kLowResolutionTick_ - 1) /
+                                        kLowResolutionTick_);
+    return epoll_wait(fd_, events_, kMaxEventsSizePerWait, timeout_ms);
+  }
 
-coro::IOEvent* Poller::PopIOEvent(int fd, io::IOType event_type) {
-  arc::coro::IOEvent* event = nullptr;
-  if (fd < kMaxFdInArray_) {
-    event = io_events_[fd][static_cast<int>(event_type)].front();
-    io_events_[fd][static_cast<int>(event_type)].pop_front();
-  } else {
-    event = extra_io_events_[fd][static_cast<int>(event_type)].front();
-    extra_io_events_[fd][static_cast<int>(event_type)].pop_front();
+  timespec ts{};
+  ts.tv_sec = timeout / 1000000000L;
+  ts.tv_nsec = timeout % 1000000000L;
+  if (is_pwait2_supported_) [[likely]] {
+    int ret = syscall(SYS_epoll_pwait2, fd_, events_, kMaxEventsSizePerWait,
+                      &ts, nullptr, 0);
+    if (ret >= 0 || errno != ENOSYS) [[likely]] {
+      return ret;
+    }
+    is_pwait2_supported_ = false;
   }
-  total_io_events_--;
-  interesting_fds_.insert(fd);
-  return event;
+  return WaitWithTimerFd(ts);
 }
 
-int Poller::GetExistingIOEvent(int fd) {
-  int cur = 0;
-  if (fd < kMaxFdInArray_) {
-    if (!io_events_[fd][static_cast<int>(io::IOType::READ)].empty()) {
-      cur |= EPOLLIN;
-    }
-    if (!io_events_[fd][static_cast<int>(io::IOType::WRITE)].empty()) {
-      cur |= EPOLLOUT;
+int EpollPoller::WaitWithTimerFd(const timespec& timeout) {
+  if (timer_fd_ < 0) [[unlikely]] {
+    timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer_fd_ < 0) {
+      throw arc::exception::IOException("TimerFd Creation Error");
     }
-  } else {
-    if (extra_io_events_.find(fd) != extra_io_events_.end() &&
-        !extra_io_events_[fd][static_cast<int>(io::IOType::READ)].empty()) {
-      cur |= EPOLLIN;
-    }
-    if (extra_io_events_.find(fd) != extra_io_events_.end() &&
-        !extra_io_events_[fd][static_cast<int>(io::IOType::WRITE)].empty()) {
-      cur |= EPOLLOUT;
+    epoll_event e_event{};
+    e_event.events = EPOLLIN;
+    e_event.data.fd = timer_fd_;
+    if (Control(EPOLL_CTL_ADD, timer_fd_, &e_event) != 0) {
+      throw arc::exception::IOException("Epoll Error When Adding TimerFd");
     }
   }
-  return cur;
+  itimerspec spec{};
+  spec.it_value = timeout;
+  if (timerfd_settime(timer_fd_, 0, &spec, nullptr) != 0) {
+    throw arc::exception::IOException("TimerFd Setting Error");
+  }
+  return epoll_wait(fd_, events_, kMaxEventsSizePerWait, -1);
 }
 
-EventBase* Poller::PopBoundEvent(coro::BoundEvent* event) {
-  switch (event->GetBountEventType()) {
-    case detail::BoundType::IO_EVENT: {
-      int fd = static_cast<int>(event->GetBoundHelper());
-      if (fd < kMaxFdInArray_) {
-        for (auto& vec : io_events_[fd]) {
-          for (auto itr = vec.begin(); itr != vec.end(); itr++) {
-            if ((*itr)->GetEventID() == event->GetBountEventID()) {
-              assert(event->GetBoundEvent() == (*itr));
-              interesting_fds_.insert(fd);
-              total_io_events_--;
-              vec.erase(itr);
-              return *itr;
-            }
-          }
-        }
-      } else {
-        for (auto& vec : extra_io_events_[fd]) {
-          for (auto itr = vec.begin(); itr != vec.end(); itr++) {
-            if ((*itr)->GetEventID() == event->GetBountEventID()) {
-              assert(event->GetBoundEvent() == (*itr));
-              interesting_fds_.insert(fd);
-              vec.erase(itr);
-              return *itr;
-            }
-          }
-        }
-      }
-      break;
-    }
-    case detail::BoundType::USER_EVENT: {
-      // TODO this is slow, find a way to optimize it
-      for (auto itr = pending_user_events_.begin();
-           itr != pending_user_events_.end(); itr++) {
-        if ((*itr)->GetEventID() == event->GetBountEventID()) {
-          assert(event->GetBoundEvent() == *itr);
-          pending_user_events_.erase(itr);
-          user_events_.erase(event->GetBountEventID());
-          return event->GetBoundEvent();
-        }
-      }
-      break;
-    }
-    case detail::BoundType::TIME_EVENT: {
-      throw arc::exception::detail::ExceptionBase(
-          "Cancelling a time event is not allowed");
-      break;
-    }
-    default:
-      throw arc::exception::detail::ExceptionBase(
-          "Cancellation Event Type not Support!");
-      break;
+bool EpollPoller::IsTimerFd(int fd) {
+  if (fd != timer_fd_) [[likely]] {
+    return false;
+  }
+  std::uint64_t expirations = 0;
+  if (read(timer_fd_, &expirations, sizeof(expirations)) < 0 &&
+      errno != EAGAIN) {
+    throw arc::exception::IOException("TimerFd Read Error");
   }
-  return nullptr;
+  return true;
 }
 
-void Poller::RemoveBoundEvent(int count) {
-  for (int i = 0; i < count && !event_pending_bound_token_map_.empty(); i++) {
-    EventID event_id = self_triggered_event_ids_[i];
-    if (event_pending_bound_token_map_.find(event_id) !=
-        event_pending_bound_token_map_.end()) {
-      auto itr = event_pending_bound_token_map_[event_id];
-      event_pending_bound_token_map_.erase(event_id);
-      auto bound_event = *itr;
-      pending_bound_events_.erase(itr);
-      if (bound_event->GetTriggerType() == detail::TriggerType::TIME_EVENT) {
-        static_cast<TimeoutEvent*>(bound_event)->SetValidity(false);
-        continue;
-      }
-      delete bound_event;
-    }
+int EpollPoller::Control(int op, int fd, epoll_event* event) {
+  counters_.control_calls.Add(1);
+  return epoll_ctl(fd_, op, fd, event);
+}
+
+int EpollPoller::ControlIO(int op, int fd, epoll_event* event) {
+  int epoll_ret = Control(op, fd, event);
+  if (epoll_ret == 0) [[likely]] {
+    return 0;
+  }
+  // the fd number may have been closed and reused by a new file without
+  // going through this poller, so the kernel registration differs from ours
+  if (op == EPOLL_CTL_MOD && errno == ENOENT) {
+    return Control(EPOLL_CTL_ADD, fd, event);
+  }
+  if (op == EPOLL_CTL_ADD && errno == EEXIST) {
+    return Control(EPOLL_CTL_MOD, fd, event);
+  }
+  if (op == EPOLL_CTL_DEL && errno == ENOENT) {
+    return 0;
   }
+  return epoll_ret;
 }
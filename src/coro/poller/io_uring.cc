@@ -0,0 +1,296 @@
+/*
+ * File: io_uring.cc
+ * Project: libarc
+ * File Created: Sunday, 18th October 2026 1:35:07 am
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <arc/coro/poller/io_uring.h>
+#include <arc/exception/io.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include <cstring>
+
+using namespace arc;
+using namespace arc::coro;
+
+IOUringPoller::IOUringPoller(bool is_high_resolution_timer)
+    : Poller(is_high_resolution_timer) {
+  io_uring_params params{};
+  fd_ = syscall(__NR_io_uring_setup, kRingEntries_, &params);
+  if (fd_ < 0) {
+    throw arc::exception::IOException("IOUring Setup Error");
+  }
+  if ((params.features & IORING_FEAT_EXT_ARG) == 0) {
+    throw arc::exception::IOException(
+        "IOUring Without IORING_FEAT_EXT_ARG Is Not Supported");
+  }
+
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  bool is_single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (is_single_mmap) {
+    sq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    cq_ring_size_ = 0;
+  }
+  sq_ring_ptr_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING);
+  if (sq_ring_ptr_ == MAP_FAILED) {
+    sq_ring_ptr_ = nullptr;
+    throw arc::exception::IOException("IOUring SQ Ring Mapping Error");
+  }
+  if (is_single_mmap) {
+    cq_ring_ptr_ = sq_ring_ptr_;
+  } else {
+    cq_ring_ptr_ = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_CQ_RING);
+    if (cq_ring_ptr_ == MAP_FAILED) {
+      cq_ring_ptr_ = nullptr;
+      // the destructor does not run for a throwing constructor, while fd_ is
+      // still closed by IOBase
+      UnmapRings();
+      throw arc::exception::IOException("IOUring CQ Ring Mapping Error");
+    }
+  }
+  sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  void* sqes_ptr = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES);
+  if (sqes_ptr == MAP_FAILED) {
+    UnmapRings();
+    throw arc::exception::IOException("IOUring SQEs Mapping Error");
+  }
+  sqes_ = static_cast<io_uring_sqe*>(sqes_ptr);
+
+  char* sq_ptr = static_cast<char*>(sq_ring_ptr_);
+  sq_head_ = reinterpret_cast<unsigned*>(sq_ptr + params.sq_off.head);
+  sq_tail_ = reinterpret_cast<unsigned*>(sq_ptr + params.sq_off.tail);
+  sq_ring_mask_ = *reinterpret_cast<unsigned*>(sq_ptr + params.sq_off.ring_mask);
+  sq_ring_entries_ =
+      *reinterpret_cast<unsigned*>(sq_ptr + params.sq_off.ring_entries);
+  // sqes are always consumed in order, so the index array is an identity map
+  unsigned* sq_array = reinterpret_cast<unsigned*>(sq_ptr + params.sq_off.array);
+  for (unsigned i = 0; i < sq_ring_entries_; i++) {
+    sq_array[i] = i;
+  }
+
+  char* cq_ptr = static_cast<char*>(cq_ring_ptr_);
+  cq_head_ = reinterpret_cast<unsigned*>(cq_ptr + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<unsigned*>(cq_ptr + params.cq_off.tail);
+  cq_ring_mask_ = *reinterpret_cast<unsigned*>(cq_ptr + params.cq_off.ring_mask);
+  cqes_ = reinterpret_cast<io_uring_cqe*>(cq_ptr + params.cq_off.cqes);
+}
+
+IOUringPoller::~IOUringPoller() { UnmapRings(); }
+
+void IOUringPoller::UnmapRings() {
+  if (sqes_ != nullptr) {
+    munmap(sqes_, sqes_size_);
+    sqes_ = nullptr;
+  }
+  if (cq_ring_ptr_ != nullptr && cq_ring_ptr_ != sq_ring_ptr_) {
+    munmap(cq_ring_ptr_, cq_ring_size_);
+  }
+  cq_ring_ptr_ = nullptr;
+  if (sq_ring_ptr_ != nullptr) {
+    munmap(sq_ring_ptr_, sq_ring_size_);
+    sq_ring_ptr_ = nullptr;
+  }
+}
+
+int IOUringPoller::WaitIOEvents(coro::EventBase** todo_events,
+                                bool* is_user_event_triggered) {
+  unsigned head = *cq_head_;
+  bool has_completions = (__atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE) != head);
+  if (has_completions || next_wait_timeout_ == 0) {
+    if (to_submit_ > 0) {
+      Enter(0, 0);
+    }
+  } else {
+    Enter(1, next_wait_timeout_);
+  }
+
+  int todo_cnt = 0;
+  unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+  while (head != tail && todo_cnt < kMaxEventsSizePerWait) {
+    io_uring_cqe* cqe = &cqes_[head & cq_ring_mask_];
+    head++;
+
+    std::uint64_t user_data = cqe->user_data;
+    auto kind = static_cast<PollKind>(user_data & 0x3U);
+    std::uint32_t generation = (user_data >> 2) & 0x3fffffffU;
+    int fd = static_cast<int>(user_data >> 32);
+    if (kind == PollKind::INTERNAL) {
+      continue;
+    }
+
+    PollSlot* slot = nullptr;
+    if (kind == PollKind::USER_EVENT) {
+      slot = &user_event_poll_slot_;
+    } else if (static_cast<std::size_t>(fd) < io_poll_slots_.size())
+        [[likely]] {
+      slot = &io_poll_slots_[fd][static_cast<int>(kind)];
+    }
+    // completions of cancelled or re-armed polls are stale
+    if (slot == nullptr || !slot->is_armed ||
+        (slot->generation & 0x3fffffffU) != generation) {
+      continue;
+    }
+    slot->is_armed = false;
+    if (cqe->res == -ECANCELED) {
+      continue;
+    }
+
+    if (kind == PollKind::USER_EVENT) {
+      *is_user_event_triggered = true;
+      continue;
+    }
+    auto event_type = static_cast<io::IOType>(kind);
+    interesting_fds_.insert(fd);
+    if (HasIOEvent(fd, event_type)) {
+      todo_events[todo_cnt] = PopIOEvent(fd, event_type);
+      self_triggered_event_ids_[todo_cnt] = todo_events[todo_cnt]->GetEventID();
+      todo_cnt++;
+    }
+  }
+  __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+  return todo_cnt;
+}
+
+void IOUringPoller::RemoveIOInterest(int target_fd) {
+  if (static_cast<std::size_t>(target_fd) >= io_poll_slots_.size()) {
+    return;
+  }
+  auto& slots = io_poll_slots_[target_fd];
+  if (slots[static_cast<int>(io::IOType::READ)].is_armed) {
+    CancelPoll(target_fd, PollKind::READ,
+               slots[static_cast<int>(io::IOType::READ)]);
+  }
+  if (slots[static_cast<int>(io::IOType::WRITE)].is_armed) {
+    CancelPoll(target_fd, PollKind::WRITE,
+               slots[static_cast<int>(io::IOType::WRITE)]);
+  }
+}
+
+void IOUringPoller::TrimIOEvents() {
+  for (int fd : interesting_fds_) {
+    for (auto event_type : {io::IOType::READ, io::IOType::WRITE}) {
+      auto& slot = GetPollSlot(fd, event_type);
+      bool has_io_event = HasIOEvent(fd, event_type);
+      if (has_io_event && !slot.is_armed) {
+        ArmPoll(fd, static_cast<PollKind>(event_type), slot);
+      } else if (!has_io_event && slot.is_armed) {
+        CancelPoll(fd, static_cast<PollKind>(event_type), slot);
+      }
+    }
+  }
+  // all interested fds are in sync with the ring now
+  interesting_fds_.clear();
+
+  // the user event poll is one-shot, re-arm it after it is triggered
+  if (is_user_event_interested_ && !user_event_poll_slot_.is_armed) {
+    ArmPoll(user_event_fd_, PollKind::USER_EVENT, user_event_poll_slot_);
+  }
+}
+
+void IOUringPoller::SetUserEventInterest(bool is_interested) {
+  is_user_event_interested_ = is_interested;
+  if (is_interested && !user_event_poll_slot_.is_armed) {
+    ArmPoll(user_event_fd_, PollKind::USER_EVENT, user_event_poll_slot_);
+  } else if (!is_interested && user_event_poll_slot_.is_armed) {
+    CancelPoll(user_event_fd_, PollKind::USER_EVENT, user_event_poll_slot_);
+  }
+}
+
+IOUringPoller::PollSlot& IOUringPoller::GetPollSlot(int fd,
+                                                    io::IOType event_type) {
+  return GetFdSlot(io_poll_slots_, fd)[static_cast<int>(event_type)];
+}
+
+void IOUringPoller::ArmPoll(int fd, PollKind kind, PollSlot& slot) {
+  counters_.control_calls.Add(1);
+  io_uring_sqe* sqe = GetSQE();
+  slot.generation++;
+  slot.is_armed = true;
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = fd;
+  sqe->poll32_events = (kind == PollKind::WRITE ? POLLOUT : POLLIN);
+  sqe->user_data = EncodeUserData(fd, kind, slot.generation);
+}
+
+void IOUringPoller::CancelPoll(int fd, PollKind kind, PollSlot& slot) {
+  counters_.control_calls.Add(1);
+  io_uring_sqe* sqe = GetSQE();
+  slot.is_armed = false;
+  sqe->opcode = IORING_OP_POLL_REMOVE;
+  sqe->fd = -1;
+  sqe->addr = EncodeUserData(fd, kind, slot.generation);
+  sqe->user_data = EncodeUserData(fd, PollKind::INTERNAL, 0);
+}
+
+io_uring_sqe* IOUringPoller::GetSQE() {
+  unsigned tail = *sq_tail_;
+  if (tail - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >= sq_ring_entries_)
+      [[unlikely]] {
+    // the submission queue is full, flush it before queueing more
+    Enter(0, 0);
+    if (tail - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >=
+        sq_ring_entries_) {
+      throw arc::exception::IOException("IOUring Submission Queue Overflow");
+    }
+  }
+  io_uring_sqe* sqe = &sqes_[tail & sq_ring_mask_];
+  std::memset(sqe, 0, sizeof(io_uring_sqe));
+  // the kernel only reads sqes inside io_uring_enter, so the tail can be
+  // published before the sqe is filled
+  __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+  to_submit_++;
+  return sqe;
+}
+
+int IOUringPoller::Enter(unsigned min_complete, std::int64_t timeout) {
+  __kernel_timespec ts{};
+  io_uring_getevents_arg arg{};
+  unsigned flags = IORING_ENTER_EXT_ARG;
+  if (min_complete > 0) {
+    flags |= IORING_ENTER_GETEVENTS;
+    if (timeout >= 0) {
+      ts.tv_sec = timeout / 1000000000L;
+      ts.tv_nsec = timeout % 1000000000L;
+      arg.ts = reinterpret_cast<std::uint64_t>(&ts);
+    }
+  }
+  int ret = syscall(__NR_io_uring_enter, fd_, to_submit_, min_complete, flags,
+                    &arg, sizeof(arg));
+  to_submit_ = *sq_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+  if (ret < 0) {
+    if (errno == EINTR || errno == ETIME || errno == EBUSY ||
+        errno == EAGAIN) {
+      return 0;
+    }
+    throw arc::exception::IOException("IOUring Enter Error");
+  }
+  return ret;
+}
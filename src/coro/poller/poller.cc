@@ -0,0 +1,415 @@
+/*
+ * File: poller.cc
+ * Project: libarc
+ * File Created: Sunday, 18th October 2026 1:32:36 am
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <arc/coro/poller/poller.h>
+#include <arc/exception/io.h>
+#include <sys/eventfd.h>
+#include <sys/prctl.h>
+
+using namespace arc;
+using namespace arc::coro;
+
+Poller::Poller(bool is_high_resolution_timer)
+    : is_high_resolution_timer_(is_high_resolution_timer),
+      time_events_(detail::GetCurrentTime(),
+                   is_high_resolution_timer ? kHighResolutionTick_
+                                            : kLowResolutionTick_) {
+  user_event_fd_ = eventfd(0, EFD_NONBLOCK);
+  if (user_event_fd_ < 0) {
+    throw arc::exception::IOException("EventFd Creation Error");
+  }
+  if (is_high_resolution_timer_) {
+    // the default 50us slack of the loop thread would dominate short sleeps
+    prctl(PR_SET_TIMERSLACK, 1UL, 0UL, 0UL, 0UL);
+  }
+}
+
+Poller::~Poller() {
+  std::lock_guard guard(poller_lock_);
+  if (user_event_fd_ >= 0) {
+    close(user_event_fd_);
+  }
+}
+
+int Poller::WaitEvents(coro::EventBase** todo_events) {
+  bool is_user_event_triggered = false;
+
+  // io events
+  int todo_cnt = WaitIOEvents(todo_events, &is_user_event_triggered);
+  counters_.io_events.Add(todo_cnt);
+  int counted_cnt = todo_cnt;
+
+  // time events
+  if (!time_events_.Empty() && todo_cnt < kMaxEventsSizePerWait) {
+    std::int64_t current_time = detail::GetCurrentTime();
+    while (todo_cnt < kMaxEventsSizePerWait) {
+      auto time_event = time_events_.PopExpired(current_time);
+      if (time_event == nullptr) {
+        break;
+      }
+      if (time_event->IsTrigger()) [[unlikely]] {
+        TriggerBoundEvent(
+            static_cast<TimeoutEvent*>(time_event)->GetBountEventID(),
+            static_cast<TimeoutEvent*>(time_event));
+      } else {
+        todo_events[todo_cnt] = time_event;
+        self_triggered_event_ids_[todo_cnt] =
+            todo_events[todo_cnt]->GetEventID();
+        todo_cnt++;
+      }
+    }
+    counters_.time_events.Add(todo_cnt - counted_cnt);
+    counted_cnt = todo_cnt;
+  }
+
+  std::lock_guard guard(poller_lock_);
+  // user events or dispatched events
+  bool need_to_write_again = false;
+  std::uint64_t event_read = 0;
+  if (is_user_event_triggered) {
+    int read_bytes = read(user_event_fd_, &event_read, sizeof(event_read));
+    if (read_bytes != sizeof(event_read)) {
+      throw arc::exception::IOException(
+          "Read user event or dispatched event error");
+    }
+
+    // check triggered user event
+    auto triggered_event_itr = triggered_user_events_.begin();
+    while (triggered_event_itr != triggered_user_events_.end()) {
+      if (todo_cnt < kMaxEventsSizePerWait) {
+        todo_events[todo_cnt] = *triggered_event_itr;
+        self_triggered_event_ids_[todo_cnt] =
+            todo_events[todo_cnt]->GetEventID();
+        user_events_.erase(todo_events[todo_cnt]->GetEventID());
+        todo_cnt++;
+        triggered_event_itr = triggered_user_events_.erase(triggered_event_itr);
+      } else {
+        need_to_write_again = true;
+        break;
+      }
+    }
+    counters_.user_events.Add(todo_cnt - counted_cnt);
+    counted_cnt = todo_cnt;
+  }
+
+  // remove triggered bound events
+  RemoveBoundEvent(todo_cnt);
+
+  // check triggered bound event
+  auto triggered_bound_event_itr = triggered_bound_events_.begin();
+  while (triggered_bound_event_itr != triggered_bound_events_.end()) {
+    if (todo_cnt < kMaxEventsSizePerWait) {
+      auto triggered_bound_event = PopBoundEvent(*triggered_bound_event_itr);
+      if (triggered_bound_event) {
+        triggered_bound_event->SetInterrupted(true);
+        todo_events[todo_cnt] = triggered_bound_event;
+        todo_cnt++;
+      }
+    } else {
+      need_to_write_again = true;
+      break;
+    }
+    delete *triggered_bound_event_itr;
+    triggered_bound_event_itr =
+        triggered_bound_events_.erase(triggered_bound_event_itr);
+  }
+  counters_.bound_events.Add(todo_cnt - counted_cnt);
+
+  // re-write again if todo count supercede the max allowed events
+  if (need_to_write_again) {
+    // need to do it in the next wait routine
+    event_read = 1;
+    int wrote = write(user_event_fd_, &event_read, sizeof(event_read));
+    if (wrote != sizeof(event_read)) {
+      throw arc::exception::IOException(
+          "Write user event or dispatched event in poller wait error");
+    }
+  }
+
+  return todo_cnt;
+}
+
+void Poller::AddIOEvent(coro::IOEvent* event) {
+  event->SetEventID(max_event_id_.fetch_add(1, std::memory_order::relaxed));
+  auto target_fd = event->GetFd();
+  // throws for a closed socket before anything is recorded
+  auto& waiters = GetFdSlot(io_slots_, target_fd)
+                      .waiters[static_cast<int>(event->GetIOType())];
+  total_io_events_++;
+  interesting_fds_.insert(target_fd);
+  LinkIOEvent(waiters, event);
+}
+
+void Poller::AddTimeEvent(coro::TimeEvent* event) {
+  event->SetEventID(max_event_id_.fetch_add(1, std::memory_order::relaxed));
+  time_events_.Add(event);
+}
+
+void Poller::AddUserEvent(coro::UserEvent* event) {
+  std::lock_guard guard(poller_lock_);
+  event->SetEventID(max_event_id_.fetch_add(1, std::memory_order::relaxed));
+  pending_user_events_.push_back(event);
+  event->SetIterator(std::prev(pending_user_events_.end()));
+  user_events_.insert({event->GetEventID(), event});
+}
+
+void Poller::AddBoundEvent(coro::BoundEvent* event) {
+  std::lock_guard guard(poller_lock_);
+  pending_bound_events_.push_back(event);
+  auto itr = std::prev(pending_bound_events_.end());
+  event_pending_bound_token_map_[event->GetBountEventID()] = itr;
+  event->SetIterator(itr);
+  if (event->GetTriggerType() == detail::TriggerType::TIME_EVENT) {
+    time_events_.Add(static_cast<TimeoutEvent*>(event));
+  }
+}
+
+void Poller::RemoveAllIOEvents(int target_fd) {
+  if (target_fd < 0) [[unlikely]] {
+    return;
+  }
+  if (static_cast<std::size_t>(target_fd) < io_slots_.size()) [[likely]] {
+    for (auto& waiters : io_slots_[target_fd].waiters) {
+      while (waiters.head != nullptr) {
+        auto event = waiters.head;
+        UnlinkIOEvent(waiters, event);
+        event->Resume();
+        delete event;
+        total_io_events_--;
+      }
+    }
+  }
+
+  if (interesting_fds_.find(target_fd) != interesting_fds_.end()) {
+    interesting_fds_.erase(target_fd);
+  }
+
+  RemoveIOInterest(target_fd);
+}
+
+void Poller::TrimUserEvents() {
+  std::lock_guard guard(poller_lock_);
+  // bound events are triggered through the eventfd as well, e.g. the ones
+  // registered to an already cancelled token
+  bool should_be_interested = !pending_user_events_.empty() ||
+                              !triggered_user_events_.empty() ||
+                              !triggered_bound_events_.empty() ||
+                              is_dispatcher_registered_;
+  if (is_user_event_interested_ == should_be_interested) {
+    return;
+  }
+  SetUserEventInterest(should_be_interested);
+  is_user_event_interested_ = should_be_interested;
+}
+
+void Poller::TrimTimeEvents() {
+  std::int64_t next_expire_time = time_events_.GetNextExpireTime();
+  if (next_expire_time < 0) {
+    next_wait_timeout_ = -1;  // wait infinitely if no time event
+    return;
+  }
+  next_wait_timeout_ =
+      std::max((std::int64_t)0, next_expire_time - detail::GetCurrentTime());
+}
+
+bool Poller::TriggerUserEvent(EventID event_id) {
+  std::lock_guard guard(poller_lock_);
+  auto event_itr = user_events_.find(event_id);
+  if (event_itr == user_events_.end()) [[unlikely]] {
+    return false;
+  }
+  auto event = event_itr->second;
+  pending_user_events_.erase(event->GetIterator());
+  triggered_user_events_.push_back(event);
+
+  // trigger self
+  std::uint64_t i = 1;
+  if (write(user_event_fd_, &i, sizeof(i)) < 0) {
+    throw arc::exception::IOException("Trigger User Event Error");
+  }
+  return true;
+}
+
+coro::UserEvent* Poller::PopUserEvent(EventID event_id) {
+  std::lock_guard guard(poller_lock_);
+  auto event_itr = user_events_.find(event_id);
+  if (event_itr == user_events_.end()) [[unlikely]] {
+    return nullptr;
+  }
+  auto event = event_itr->second;
+  pending_user_events_.erase(event->GetIterator());
+  user_events_.erase(event_itr);
+  RemoveBoundEventOf(event_id);
+  counters_.user_events.Add(1);
+  return event;
+}
+
+void Poller::TriggerBoundEvent(EventID bound_event_id,
+                               coro::BoundEvent* event) {
+  std::lock_guard guard(poller_lock_);
+  auto event_pending_bound_token_map_itr =
+      event_pending_bound_token_map_.find(bound_event_id);
+  if (event_pending_bound_token_map_itr ==
+      event_pending_bound_token_map_.end()) {
+    return;
+  }
+  pending_bound_events_.erase(event->GetIterator());
+  triggered_bound_events_.push_back(event);
+  event_pending_bound_token_map_.erase(event_pending_bound_token_map_itr);
+
+  // trigger self
+  std::uint64_t i = 1;
+  if (write(user_event_fd_, &i, sizeof(i)) < 0) {
+    throw arc::exception::IOException("Trigger Bound Event Error");
+  }
+}
+
+int Poller::Register() {
+  std::lock_guard guard(poller_lock_);
+  is_dispatcher_registered_ = true;
+  return user_event_fd_;
+}
+
+void Poller::DeRegister() {
+  std::lock_guard guard(poller_lock_);
+  is_dispatcher_registered_ = false;
+}
+
+bool Poller::HasIOEvent(int fd, io::IOType event_type) {
+  return static_cast<std::size_t>(fd) < io_slots_.size() &&
+         io_slots_[fd].waiters[static_cast<int>(event_type)].head != nullptr;
+}
+
+coro::IOEvent* Poller::FrontIOEvent(int fd, io::IOType event_type) {
+  return io_slots_[fd].waiters[static_cast<int>(event_type)].head;
+}
+
+coro::IOEvent* Poller::PopIOEvent(int fd, io::IOType event_type) {
+  auto& waiters = io_slots_[fd].waiters[static_cast<int>(event_type)];
+  arc::coro::IOEvent* event = waiters.head;
+  UnlinkIOEvent(waiters, event);
+  total_io_events_--;
+  interesting_fds_.insert(fd);
+  return event;
+}
+
+void Poller::LinkIOEvent(IOWaiterList& waiters, coro::IOEvent* event) {
+  event->prev_io_event_ = waiters.tail;
+  event->next_io_event_ = nullptr;
+  if (waiters.tail != nullptr) {
+    waiters.tail->next_io_event_ = event;
+  } else {
+    waiters.head = event;
+  }
+  waiters.tail = event;
+}
+
+void Poller::UnlinkIOEvent(IOWaiterList& waiters, coro::IOEvent* event) {
+  if (event->prev_io_event_ != nullptr) {
+    event->prev_io_event_->next_io_event_ = event->next_io_event_;
+  } else {
+    waiters.head = event->next_io_event_;
+  }
+  if (event->next_io_event_ != nullptr) {
+    event->next_io_event_->prev_io_event_ = event->prev_io_event_;
+  } else {
+    waiters.tail = event->prev_io_event_;
+  }
+  event->prev_io_event_ = nullptr;
+  event->next_io_event_ = nullptr;
+}
+
+EventBase* Poller::PopBoundEvent(coro::BoundEvent* event) {
+  switch (event->GetBountEventType()) {
+    case detail::BoundType::IO_EVENT: {
+      // the io event may have been resumed and deleted already, so it is
+      // looked up by its id among the waiters of its fd
+      int fd = static_cast<int>(event->GetBoundHelper());
+      if (static_cast<std::size_t>(fd) >= io_slots_.size()) {
+        break;
+      }
+      for (auto& waiters : io_slots_[fd].waiters) {
+        for (auto io_event = waiters.head; io_event != nullptr;
+             io_event = io_event->next_io_event_) {
+          if (io_event->GetEventID() == event->GetBountEventID()) {
+            assert(event->GetBoundEvent() == io_event);
+            UnlinkIOEvent(waiters, io_event);
+            interesting_fds_.insert(fd);
+            total_io_events_--;
+            return io_event;
+          }
+        }
+      }
+      break;
+    }
+    case detail::BoundType::USER_EVENT: {
+      // TODO this is slow, find a way to optimize it
+      for (auto itr = pending_user_events_.begin();
+           itr != pending_user_events_.end(); itr++) {
+        if ((*itr)->GetEventID() == event->GetBountEventID()) {
+          assert(event->GetBoundEvent() == *itr);
+          pending_user_events_.erase(itr);
+          user_events_.erase(event->GetBountEventID());
+          return event->GetBoundEvent();
+        }
+      }
+      break;
+    }
+    case detail::BoundType::TIME_EVENT: {
+      throw arc::exception::detail::ExceptionBase(
+          "Cancelling a time event is not allowed");
+      break;
+    }
+    default:
+      throw arc::exception::detail::ExceptionBase(
+          "Cancellation Event Type not Support!");
+      break;
+  }
+  return nullptr;
+}
+
+void Poller::RemoveBoundEvent(int count) {
+  for (int i = 0; i < count && !event_pending_bound_token_map_.empty(); i++) {
+    RemoveBoundEventOf(self_triggered_event_ids_[i]);
+  }
+}
+
+void Poller::RemoveBoundEventOf(EventID event_id) {
+  auto map_itr = event_pending_bound_token_map_.find(event_id);
+  if (map_itr == event_pending_bound_token_map_.end()) {
+    return;
+  }
+  auto itr = map_itr->second;
+  event_pending_bound_token_map_.erase(map_itr);
+  auto bound_event = *itr;
+  pending_bound_events_.erase(itr);
+  if (bound_event->GetTriggerType() == detail::TriggerType::TIME_EVENT) {
+    time_events_.Remove(static_cast<TimeoutEvent*>(bound_event));
+  }
+  delete bound_event;
+}
@@ -0,0 +1,217 @@
+/*
+ * File: runtime.cc
+ * Project: libarc
+ * File Created: Sunday, 18th October 2026 2:58:00 am
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <arc/coro/runtime.h>
+#include <arc/exception/io.h>
+#include <arc/utils/cpu.h>
+#include <linux/filter.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstdint>
+
+using namespace arc::coro;
+
+Runtime::Runtime(const RuntimeOptions& options) : options_(options) {
+  int thread_count = options_.thread_count;
+  if (thread_count <= 0) {
+    thread_count = std::max(1U, std::thread::hardware_concurrency());
+  }
+  handles_.resize(thread_count, -1);
+  serving_acceptors_.resize(thread_count, 0);
+  if (options_.pin_threads) {
+    // cpus outside the affinity mask of the process cannot be pinned to
+    auto allowed_cpus = utils::GetAllowedCpus();
+    for (int i = 0; i < thread_count; i++) {
+      loop_cpus_.push_back(allowed_cpus[i % allowed_cpus.size()]);
+    }
+  }
+  for (int i = 0; i < thread_count; i++) {
+    threads_.emplace_back(&Runtime::LoopMain, this, i);
+  }
+  std::unique_lock guard(lock_);
+  cond_.wait(guard, [this]() { return started_count_ == GetThreadCount(); });
+}
+
+Runtime::~Runtime() {
+  Shutdown();
+  Join();
+}
+
+void Runtime::LoopMain(int index) {
+  auto event_loop_options = options_.event_loop_options;
+  if (options_.pin_threads) {
+    event_loop_options.cpu_affinity = loop_cpus_[index];
+  }
+  EventLoop::SetLocalOptions(event_loop_options);
+  auto& event_loop = EventLoop::GetLocalInstance();
+  event_loop.ResigerConsumer();
+  {
+    std::lock_guard guard(lock_);
+    handles_[index] = event_loop.GetEventHandle();
+    started_count_++;
+  }
+  cond_.notify_all();
+
+  event_loop.InitDo();
+  while (!IsShutdown()) {
+    event_loop.Do();
+  }
+  // listeners are registered to this loop, so they are closed here
+  while (serving_acceptors_[index] > 0) {
+    event_loop.Do();
+  }
+  event_loop.DeResigerConsumer();
+
+  // the eventfd is closed with the loop, so wait until Shutdown has written
+  // to all of them
+  std::unique_lock guard(lock_);
+  cond_.wait(guard, [this]() { return is_woken_up_; });
+}
+
+void Runtime::Run(Task<void>&& task) {
+  Spawn(std::move(task));
+  Join();
+}
+
+void Runtime::Spawn(Task<void>&& task) {
+  SpawnTo(next_loop_.fetch_add(1, std::memory_order::relaxed) %
+              GetThreadCount(),
+          std::move(task));
+}
+
+void Runtime::SpawnOnEachLoop(
+    const std::function<Task<void>(int)>& task_factory) {
+  for (int i = 0; i < GetThreadCount(); i++) {
+    SpawnTo(i, task_factory(i));
+  }
+}
+
+namespace {
+
+Task<void> DispatchWhenSpace(Task<void> task,
+                             EventLoopWakeUpHandle consumer_id) {
+  // the task is destroyed if the loop has been deregistered meanwhile
+  co_await BoundedDispatchTo(std::move(task), consumer_id);
+}
+
+}  // namespace
+
+void Runtime::SpawnTo(int index, Task<void>&& task) {
+  if (IsShutdown()) {
+    throw arc::exception::detail::ExceptionBase(
+        "Cannot spawn a task after the runtime is shut down");
+  }
+  task.SetNeedClean(true);
+  auto handle = task.GetCoroutine();
+  auto& dispatcher = CoroutineDispatcher::GetInstance();
+  while (true) {
+    switch (dispatcher.TryEnqueueToSpecific(handles_[index], handle)) {
+      case EnqueueResult::ENQUEUED:
+        return;
+      case EnqueueResult::CLOSED:
+        handle.destroy();
+        throw arc::exception::detail::ExceptionBase(
+            "Cannot spawn a task after the runtime is shut down");
+      case EnqueueResult::FULL:
+        break;
+    }
+    if (IsLoopThread()) {
+      // blocking here could wait for the queue of this very loop
+      EnsureFuture(DispatchWhenSpace(std::move(task), handles_[index]));
+      return;
+    }
+    std::binary_semaphore space(0);
+    if (dispatcher.AddSpaceWaiter(handles_[index],
+                                  SpaceWaiter{-1, -1, &space})) {
+      space.acquire();
+    }
+  }
+}
+
+bool Runtime::IsLoopThread() const {
+  for (auto& thread : threads_) {
+    if (thread.get_id() == std::this_thread::get_id()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void Runtime::Shutdown() {
+  if (is_shutdown_.exchange(true)) {
+    return;
+  }
+  serve_token_.Cancel();
+  {
+    std::lock_guard guard(lock_);
+    for (auto handle : handles_) {
+      std::uint64_t count = 1;
+      if (write(handle, &count, sizeof(count)) < 0) {
+        throw arc::exception::IOException("Wake Up EventLoop Error");
+      }
+    }
+    is_woken_up_ = true;
+  }
+  cond_.notify_all();
+}
+
+void Runtime::Join() {
+  for (auto& thread : threads_) {
+    if (thread.joinable() && thread.get_id() != std::this_thread::get_id()) {
+      thread.join();
+    }
+  }
+}
+
+void Runtime::AttachCpuSteeringProgram(int fd) const {
+  // returns the index of the loop pinned to the cpu receiving the packet in
+  // the reuseport group, which is in the loop order
+  std::vector<sock_filter> code = {
+      {BPF_LD | BPF_W | BPF_ABS, 0, 0,
+       static_cast<std::uint32_t>(SKF_AD_OFF + SKF_AD_CPU)},
+  };
+  for (std::size_t i = 0; i < loop_cpus_.size(); i++) {
+    if (i > 0 && loop_cpus_[i] == loop_cpus_[0]) {
+      // the loops wrap around the cpus from here on
+      break;
+    }
+    code.push_back({BPF_JMP | BPF_JEQ | BPF_K, 0, 1,
+                    static_cast<std::uint32_t>(loop_cpus_[i])});
+    code.push_back({BPF_RET | BPF_K, 0, 0, static_cast<std::uint32_t>(i)});
+  }
+  // out of the group, so the kernel falls back to hashing
+  code.push_back({BPF_RET | BPF_K, 0, 0, UINT32_MAX});
+  sock_fprog program{};
+  program.len = code.size();
+  program.filter = code.data();
+  if (setsockopt(fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &program,
+                 sizeof(program)) < 0) {
+    throw arc::exception::IOException("Attach Reuseport Program Error");
+  }
+}
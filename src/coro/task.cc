@@ -26,6 +26,7 @@
  * IN THE SOFTWARE.
  */
 
+#include <arc/coro/eventloop_group.h>
 #include <arc/coro/task.h>
 
 using namespace arc::coro;
@@ -51,4 +52,76 @@ TimeAwaiter arc::coro::SleepFor(
   return TimeAwaiter(duration);
 }
 
-TimeAwaiter arc::coro::Yield() { return TimeAwaiter(std::chrono::seconds(0)); }
+YieldAwaiter arc::coro::Yield() { return YieldAwaiter(); }
+
+ResumeOnAwaiter arc::coro::ResumeOn(EventLoopWakeUpHandle consumer_id) {
+  return ResumeOnAwaiter(consumer_id);
+}
+
+ResumeOnAwaiter arc::coro::ResumeOnEventLoop(EventLoopID event_loop_id) {
+  auto& group = EventLoopGroup::GetInstance();
+  std::lock_guard guard(group.EventLoopGroupLock());
+  auto loop = group.GetEventLoopNoLock(event_loop_id);
+  if (loop == nullptr) {
+    throw arc::exception::detail::ExceptionBase(
+        "Event loop " + std::to_string(event_loop_id) + " does not exist.");
+  }
+  return ResumeOnAwaiter(loop->GetEventHandle());
+}
+
+namespace {
+
+Task<void> ResumeOnWhenSpaceTask(EventLoopWakeUpHandle consumer_id,
+                                 std::coroutine_handle<void> handle) {
+  auto& dispatcher = CoroutineDispatcher::GetInstance();
+  while (true) {
+    co_await DispatchSpaceAwaiter(consumer_id);
+    switch (dispatcher.TryEnqueueToSpecific(consumer_id, handle)) {
+      case EnqueueResult::ENQUEUED:
+        co_return;
+      case EnqueueResult::CLOSED:
+        handle.resume();
+        co_return;
+      case EnqueueResult::FULL:
+        break;
+    }
+  }
+}
+
+}  // namespace
+
+void arc::coro::ResumeOnWhenSpace(EventLoopWakeUpHandle consumer_id,
+                                  std::coroutine_handle<void> handle) {
+  EnsureFuture(ResumeOnWhenSpaceTask(consumer_id, handle));
+}
+
+Task<bool> arc::coro::BoundedDispatchTo(Task<void> task,
+                                        EventLoopWakeUpHandle consumer_id) {
+  std::coroutine_handle<void> handle = task.GetCoroutine();
+  {
+    // the consumer cleans it up once it finishes
+    Task<void> dispatched = std::move(task);
+    dispatched.SetNeedClean(true);
+  }
+  auto& dispatcher = CoroutineDispatcher::GetInstance();
+  while (true) {
+    switch (dispatcher.TryEnqueueToSpecific(consumer_id, handle)) {
+      case EnqueueResult::ENQUEUED:
+        co_return true;
+      case EnqueueResult::CLOSED:
+        handle.destroy();
+        co_return false;
+      case EnqueueResult::FULL:
+        co_await DispatchSpaceAwaiter(consumer_id);
+        break;
+    }
+  }
+}
+
+Task<bool> arc::coro::BoundedDispatch(Task<void> task) {
+  auto& loop = EventLoop::GetLocalInstance();
+  auto consumer_id = CoroutineDispatcher::GetInstance().SelectConsumer(
+      loop.GetOptions().dispatch_policy,
+      loop.GetOptions().prefer_local_numa_consumers ? loop.GetNumaNode() : -1);
+  return BoundedDispatchTo(std::move(task), consumer_id);
+}
@@ -0,0 +1,130 @@
+/*
+ * File: epoch.cc
+ * Project: libarc
+ * File Created: Sunday, 18th October 2026 5:14:29 am
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <arc/coro/utils/epoch.h>
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <thread>
+
+using namespace arc::coro;
+
+namespace {
+
+struct alignas(64) EpochRecord {
+  // the global epoch when the read section started, 0 if not reading
+  std::atomic<std::uint64_t> epoch{0};
+  std::atomic<bool> is_used{true};
+  // nested read sections, only touched by the owner thread
+  int depth{0};
+  EpochRecord* next{nullptr};
+};
+
+// 0 marks idle records
+std::atomic<std::uint64_t> global_epoch{1};
+// records are reused by later threads but never freed
+std::atomic<EpochRecord*> epoch_records{nullptr};
+
+thread_local EpochRecord* local_epoch_record = nullptr;
+thread_local bool is_local_epoch_record_closed = false;
+
+EpochRecord* AcquireRecord() {
+  for (auto record = epoch_records.load(std::memory_order::acquire);
+       record != nullptr; record = record->next) {
+    bool is_used = false;
+    if (!record->is_used.load(std::memory_order::relaxed) &&
+        record->is_used.compare_exchange_strong(is_used, true)) {
+      return record;
+    }
+  }
+  auto record = new EpochRecord();
+  record->next = epoch_records.load(std::memory_order::relaxed);
+  while (!epoch_records.compare_exchange_weak(record->next, record,
+                                              std::memory_order::release,
+                                              std::memory_order::relaxed)) {
+  }
+  return record;
+}
+
+// gives the record back when the thread exits
+struct LocalEpochRecordGuard {
+  ~LocalEpochRecordGuard() {
+    is_local_epoch_record_closed = true;
+    if (local_epoch_record != nullptr) {
+      local_epoch_record->is_used.store(false, std::memory_order::release);
+      local_epoch_record = nullptr;
+    }
+  }
+};
+
+inline EpochRecord* GetLocalRecord() {
+  if (local_epoch_record != nullptr) [[likely]] {
+    return local_epoch_record;
+  }
+  local_epoch_record = AcquireRecord();
+  // destructors of other thread locals may still read after the guard is
+  // gone, their record is then kept forever
+  if (!is_local_epoch_record_closed) {
+    thread_local LocalEpochRecordGuard guard;
+  }
+  return local_epoch_record;
+}
+
+}  // namespace
+
+EpochReadGuard::EpochReadGuard() {
+  auto record = GetLocalRecord();
+  if (record->depth++ == 0) {
+    // published before the protected pointers are loaded
+    record->epoch.store(global_epoch.load());
+  }
+}
+
+EpochReadGuard::~EpochReadGuard() {
+  auto record = local_epoch_record;
+  if (--record->depth == 0) {
+    record->epoch.store(0, std::memory_order::release);
+  }
+}
+
+void arc::coro::SynchronizeEpoch() {
+  assert(local_epoch_record == nullptr || local_epoch_record->depth == 0);
+  // readers starting from this epoch see the pointers swapped before
+  std::uint64_t target = global_epoch.fetch_add(1) + 1;
+  for (auto record = epoch_records.load(std::memory_order::acquire);
+       record != nullptr; record = record->next) {
+    while (true) {
+      std::uint64_t epoch = record->epoch.load();
+      if (epoch == 0 || epoch >= target) {
+        break;
+      }
+      std::this_thread::yield();
+    }
+  }
+}
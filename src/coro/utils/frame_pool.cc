@@ -0,0 +1,210 @@
+/*
+ * File: frame_pool.cc
+ * Project: libarc
+ * File Created: Sunday, 18th October 2026 2:00:58 am
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <arc/coro/utils/frame_pool.h>
+
+#include <new>
+
+using namespace arc::coro;
+
+namespace {
+
+// the list of remote frees is closed by this mark after the owner exits
+const auto kClosedMark = reinterpret_cast<void*>(std::uintptr_t{1});
+
+thread_local FramePool* local_frame_pool = nullptr;
+thread_local bool is_local_frame_pool_closed = false;
+
+}  // namespace
+
+struct FramePool::LocalInstanceGuard {
+  ~LocalInstanceGuard() {
+    is_local_frame_pool_closed = true;
+    if (local_frame_pool != nullptr) {
+      local_frame_pool->Orphan();
+      local_frame_pool = nullptr;
+    }
+  }
+};
+
+FramePool* FramePool::GetLocalInstance() {
+  if (local_frame_pool != nullptr) [[likely]] {
+    return local_frame_pool;
+  }
+  if (is_local_frame_pool_closed) [[unlikely]] {
+    return nullptr;
+  }
+  thread_local LocalInstanceGuard guard;
+  local_frame_pool = new FramePool();
+  return local_frame_pool;
+}
+
+void* FramePool::Allocate(std::size_t size) {
+  std::size_t size_class = (size == 0 ? 0 : (size - 1) / kGranularity_);
+  FramePool* pool = GetLocalInstance();
+  FrameHeader* header = nullptr;
+  if (size_class < kSizeClasses_ && pool != nullptr) [[likely]] {
+    header = pool->AllocateFrame(size_class);
+  } else {
+    header = static_cast<FrameHeader*>(
+        ::operator new(sizeof(FrameHeader) + size));
+    header->owner = nullptr;
+    header->size_class = kOversizedClass_;
+    if (pool != nullptr) {
+      pool->oversized_allocations_++;
+    }
+  }
+  return header + 1;
+}
+
+void FramePool::Deallocate(void* ptr) noexcept {
+  if (ptr == nullptr) [[unlikely]] {
+    return;
+  }
+  FrameHeader* header = static_cast<FrameHeader*>(ptr) - 1;
+  FramePool* owner = header->owner;
+  if (owner == nullptr) [[unlikely]] {
+    ::operator delete(header);
+    return;
+  }
+  if (owner == local_frame_pool) [[likely]] {
+    owner->FreeLocal(header);
+  } else {
+    owner->FreeRemote(header);
+  }
+}
+
+FramePoolStats FramePool::GetLocalStats() {
+  FramePoolStats stats{};
+  FramePool* pool = GetLocalInstance();
+  if (pool == nullptr) {
+    return stats;
+  }
+  pool->DrainRemoteFrees();
+  for (std::uint32_t i = 0; i < kSizeClasses_; i++) {
+    if (pool->allocations_[i] == 0) {
+      continue;
+    }
+    stats.allocations += pool->allocations_[i];
+    stats.pool_hits += pool->pool_hits_[i];
+    stats.size_classes.push_back(
+        {(i + 1) * kGranularity_, pool->allocations_[i], pool->pool_hits_[i]});
+  }
+  stats.oversized_allocations = pool->oversized_allocations_;
+  stats.allocations += pool->oversized_allocations_;
+  stats.remote_deallocations = pool->remote_deallocations_;
+  return stats;
+}
+
+FramePool::FrameHeader* FramePool::AllocateFrame(std::uint32_t size_class) {
+  allocations_[size_class]++;
+  live_frames_++;
+  if (free_lists_[size_class] == nullptr &&
+      remote_frees_.load(std::memory_order::relaxed) != nullptr) {
+    DrainRemoteFrees();
+  }
+  FrameHeader* header = free_lists_[size_class];
+  if (header != nullptr) [[likely]] {
+    free_lists_[size_class] = header->next;
+    free_counts_[size_class]--;
+    pool_hits_[size_class]++;
+  } else {
+    header = static_cast<FrameHeader*>(::operator new(GetBlockSize(size_class)));
+    header->size_class = size_class;
+  }
+  header->owner = this;
+  return header;
+}
+
+void FramePool::FreeLocal(FrameHeader* header) {
+  live_frames_--;
+  std::uint32_t size_class = header->size_class;
+  if (free_counts_[size_class] >= kMaxCachedFramesPerClass_) [[unlikely]] {
+    ::operator delete(header);
+    return;
+  }
+  header->next = free_lists_[size_class];
+  free_lists_[size_class] = header;
+  free_counts_[size_class]++;
+}
+
+void FramePool::FreeRemote(FrameHeader* header) {
+  FrameHeader* head = remote_frees_.load(std::memory_order::acquire);
+  do {
+    if (head == kClosedMark) [[unlikely]] {
+      ::operator delete(header);
+      // the last frame in use deletes the orphaned pool
+      if (orphaned_frames_.fetch_sub(1, std::memory_order::acq_rel) == 1) {
+        delete this;
+      }
+      return;
+    }
+    header->next = head;
+  } while (!remote_frees_.compare_exchange_weak(
+      head, header, std::memory_order::release, std::memory_order::acquire));
+}
+
+void FramePool::DrainRemoteFrees() {
+  FrameHeader* header =
+      remote_frees_.exchange(nullptr, std::memory_order::acquire);
+  while (header != nullptr) {
+    FrameHeader* next = header->next;
+    remote_deallocations_++;
+    FreeLocal(header);
+    header = next;
+  }
+}
+
+void FramePool::Orphan() {
+  FrameHeader* header = remote_frees_.exchange(
+      static_cast<FrameHeader*>(kClosedMark), std::memory_order::acq_rel);
+  while (header != nullptr) {
+    FrameHeader* next = header->next;
+    live_frames_--;
+    ::operator delete(header);
+    header = next;
+  }
+  for (std::uint32_t i = 0; i < kSizeClasses_; i++) {
+    header = free_lists_[i];
+    while (header != nullptr) {
+      FrameHeader* next = header->next;
+      ::operator delete(header);
+      header = next;
+    }
+    free_lists_[i] = nullptr;
+    free_counts_[i] = 0;
+  }
+  // frames freed by other threads before this point have made the counter
+  // negative, whoever brings it back to zero deletes the pool
+  std::int64_t live_frames = live_frames_;
+  if (orphaned_frames_.fetch_add(live_frames, std::memory_order::acq_rel) +
+          live_frames ==
+      0) {
+    delete this;
+  }
+}
@@ -0,0 +1,194 @@
+/*
+ * File: timing_wheel.cc
+ * Project: libarc
+ * File Created: Sunday, 18th October 2026 1:44:56 am
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <arc/coro/utils/timing_wheel.h>
+
+#include <cassert>
+
+using namespace arc::coro;
+
+void TimingWheel::Add(TimeEvent* event) {
+  event->wheel_tick_ = event->wakeup_time_ / tick_size_;
+  Place(event);
+  size_++;
+}
+
+void TimingWheel::Remove(TimeEvent* event) {
+  if (event->wheel_slot_ < 0) [[unlikely]] {
+    return;
+  }
+  Unlink(event);
+  size_--;
+}
+
+TimeEvent* TimingWheel::PopExpired(std::int64_t current_time) {
+  std::int64_t current_tick = current_time / tick_size_;
+  while (slots_[kExpiredSlot_] == nullptr) {
+    if (!Advance(current_tick)) {
+      return nullptr;
+    }
+  }
+  TimeEvent* event = slots_[kExpiredSlot_];
+  Unlink(event);
+  size_--;
+  return event;
+}
+
+std::int64_t TimingWheel::GetNextExpireTime() const {
+  std::int64_t next_expire_tick = GetNextExpireTick();
+  return next_expire_tick < 0 ? -1 : next_expire_tick * tick_size_;
+}
+
+std::int64_t TimingWheel::GetNextExpireTick() const {
+  if (slots_[kExpiredSlot_] != nullptr) {
+    return current_tick_;
+  }
+  for (int level = 0; level < kLevels_; level++) {
+    if (occupied_slots_[level] == 0) {
+      continue;
+    }
+    int shift = level * kLevelBits_;
+    int slot = __builtin_ctzll(occupied_slots_[level]);
+    std::int64_t window_mask = (std::int64_t{1} << (shift + kLevelBits_)) - 1;
+    return (current_tick_ & ~window_mask) |
+           (static_cast<std::int64_t>(slot) << shift);
+  }
+  if (slots_[kOverflowSlot_] != nullptr) {
+    std::int64_t window_mask = (std::int64_t{1} << kWheelBits_) - 1;
+    return (current_tick_ | window_mask) + 1;
+  }
+  return -1;
+}
+
+void TimingWheel::Place(TimeEvent* event) {
+  std::int64_t wakeup_tick = event->wheel_tick_;
+  if (wakeup_tick <= current_tick_) {
+    Link(event, kExpiredSlot_);
+    return;
+  }
+  std::uint64_t diff = static_cast<std::uint64_t>(wakeup_tick ^ current_tick_);
+  int level = (63 - __builtin_clzll(diff)) / kLevelBits_;
+  if (level >= kLevels_) [[unlikely]] {
+    Link(event, kOverflowSlot_);
+    return;
+  }
+  int slot = (wakeup_tick >> (level * kLevelBits_)) & (kSlotsPerLevel_ - 1);
+  Link(event, level * kSlotsPerLevel_ + slot);
+}
+
+void TimingWheel::Link(TimeEvent* event, int slot) {
+  TimeEvent*& head = slots_[slot];
+  if (head == nullptr) {
+    head = event;
+    event->wheel_prev_ = event;
+    event->wheel_next_ = event;
+    if (slot < kExpiredSlot_) {
+      occupied_slots_[slot / kSlotsPerLevel_] |=
+          (std::uint64_t{1} << (slot % kSlotsPerLevel_));
+    }
+  } else {
+    // append to the tail to keep events of the same time in order
+    event->wheel_prev_ = head->wheel_prev_;
+    event->wheel_next_ = head;
+    head->wheel_prev_->wheel_next_ = event;
+    head->wheel_prev_ = event;
+  }
+  event->wheel_slot_ = slot;
+}
+
+void TimingWheel::Unlink(TimeEvent* event) {
+  int slot = event->wheel_slot_;
+  TimeEvent*& head = slots_[slot];
+  if (event->wheel_next_ == event) {
+    head = nullptr;
+    if (slot < kExpiredSlot_) {
+      occupied_slots_[slot / kSlotsPerLevel_] &=
+          ~(std::uint64_t{1} << (slot % kSlotsPerLevel_));
+    }
+  } else {
+    event->wheel_prev_->wheel_next_ = event->wheel_next_;
+    event->wheel_next_->wheel_prev_ = event->wheel_prev_;
+    if (head == event) {
+      head = event->wheel_next_;
+    }
+  }
+  event->wheel_prev_ = nullptr;
+  event->wheel_next_ = nullptr;
+  event->wheel_slot_ = -1;
+}
+
+bool TimingWheel::Advance(std::int64_t current_tick) {
+  std::int64_t next_expire_tick = GetNextExpireTick();
+  if (next_expire_tick < 0 || next_expire_tick > current_tick) {
+    // nothing is due, it is safe to move forward as no slot is skipped
+    if (current_tick > current_tick_) {
+      SetCurrentTick(current_tick);
+    }
+    return false;
+  }
+
+  for (int level = 0; level < kLevels_; level++) {
+    if (occupied_slots_[level] == 0) {
+      continue;
+    }
+    int slot = level * kSlotsPerLevel_ + __builtin_ctzll(occupied_slots_[level]);
+    SetCurrentTick(next_expire_tick);
+    // move all events of the slot to the expired list or lower levels
+    TimeEvent* event = slots_[slot];
+    while (event != nullptr) {
+      Unlink(event);
+      Place(event);
+      event = slots_[slot];
+    }
+    return true;
+  }
+
+  // only events far in the future are left
+  SetCurrentTick(next_expire_tick);
+  return true;
+}
+
+void TimingWheel::SetCurrentTick(std::int64_t current_tick) {
+  assert(current_tick >= current_tick_);
+  bool is_window_changed =
+      ((current_tick ^ current_tick_) >> kWheelBits_) != 0;
+  current_tick_ = current_tick;
+  if (is_window_changed && slots_[kOverflowSlot_] != nullptr) [[unlikely]] {
+    // re-place every overflowed event once, the ones still too far away are
+    // appended after the current tail
+    TimeEvent* tail = slots_[kOverflowSlot_]->wheel_prev_;
+    while (true) {
+      TimeEvent* event = slots_[kOverflowSlot_];
+      Unlink(event);
+      Place(event);
+      if (event == tail) {
+        break;
+      }
+    }
+  }
+}
@@ -0,0 +1,151 @@
+/*
+ * File: cpu.cc
+ * Project: libarc
+ * File Created: Sunday, 18th October 2026 3:00:52 am
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <arc/exception/io.h>
+#include <arc/utils/cpu.h>
+#include <linux/mempolicy.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace arc::utils;
+
+namespace {
+const std::string kNodeDirectory = "/sys/devices/system/node/";
+const std::string kCpuDirectory = "/sys/devices/system/cpu/";
+}  // namespace
+
+int arc::utils::GetCpuCount() {
+  return std::max(1U, std::thread::hardware_concurrency());
+}
+
+std::vector<int> arc::utils::GetAllowedCpus() {
+  std::vector<int> cpus;
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  if (sched_getaffinity(getpid(), sizeof(cpu_set), &cpu_set) == 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+      if (CPU_ISSET(cpu, &cpu_set)) {
+        cpus.push_back(cpu);
+      }
+    }
+  }
+  if (cpus.empty()) {
+    for (int cpu = 0; cpu < GetCpuCount(); cpu++) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+int arc::utils::GetNumaNodeCount() {
+  int count = 0;
+  while (std::filesystem::exists(kNodeDirectory + "node" +
+                                 std::to_string(count))) {
+    count++;
+  }
+  return std::max(count, 1);
+}
+
+int arc::utils::GetNumaNodeOfCpu(int cpu) {
+  std::string cpu_directory = kCpuDirectory + "cpu" + std::to_string(cpu);
+  for (int node = 0; node < GetNumaNodeCount(); node++) {
+    if (std::filesystem::exists(cpu_directory + "/node" +
+                                std::to_string(node))) {
+      return node;
+    }
+  }
+  return 0;
+}
+
+std::vector<int> arc::utils::GetCpusOfNumaNode(int node) {
+  std::vector<int> cpus;
+  // in the format of "0-3,8-11"
+  std::ifstream cpu_list_file(kNodeDirectory + "node" + std::to_string(node) +
+                              "/cpulist");
+  std::string range;
+  while (std::getline(cpu_list_file, range, ',')) {
+    int first = 0;
+    int last = 0;
+    char separator = 0;
+    std::istringstream range_stream(range);
+    if (!(range_stream >> first)) {
+      continue;
+    }
+    last = first;
+    if (range_stream >> separator >> last && separator != '-') {
+      last = first;
+    }
+    for (int cpu = first; cpu <= last; cpu++) {
+      cpus.push_back(cpu);
+    }
+  }
+  if (cpus.empty() && node == 0) {
+    for (int cpu = 0; cpu < GetCpuCount(); cpu++) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+int arc::utils::GetCurrentNumaNode() {
+  unsigned cpu = 0;
+  unsigned node = 0;
+  if (syscall(SYS_getcpu, &cpu, &node, nullptr) < 0) {
+    return -1;
+  }
+  return node;
+}
+
+void arc::utils::SetCurrentThreadAffinity(const std::vector<int>& cpus) {
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  for (int cpu : cpus) {
+    CPU_SET(cpu, &cpu_set);
+  }
+  if (sched_setaffinity(0, sizeof(cpu_set), &cpu_set) < 0) {
+    throw arc::exception::IOException("Set Thread Affinity Error");
+  }
+}
+
+void arc::utils::SetCurrentThreadPreferredNumaNode(int node) {
+  constexpr int kBitsPerMask = sizeof(unsigned long) * 8;
+  std::vector<unsigned long> node_mask(node / kBitsPerMask + 1, 0);
+  node_mask[node / kBitsPerMask] |= (1UL << (node % kBitsPerMask));
+  if (syscall(SYS_set_mempolicy, MPOL_PREFERRED, node_mask.data(),
+              node_mask.size() * kBitsPerMask + 1) < 0) {
+    throw arc::exception::IOException("Set Memory Policy Error");
+  }
+}
@@ -49,14 +49,35 @@
  */
 
 #include <arc/coro/eventloop_group.h>
+#include <arc/exception/base.h>
+#include <arc/utils/cpu.h>
 #include <arc/utils/thread_pool.h>
 
+#include <algorithm>
+
 using namespace arc::utils;
 
+namespace {
+std::mutex global_options_lock;
+ThreadPoolOptions global_options{};
+bool is_instance_created{false};
+
+ThreadPoolOptions TakeGlobalOptions() {
+  std::lock_guard guard(global_options_lock);
+  is_instance_created = true;
+  return global_options;
+}
+}  // namespace
+
 // the constructor just launches some amount of workers
-ThreadPool::ThreadPool(size_t threads) : stop_(false) {
+ThreadPool::ThreadPool(size_t threads, const ThreadPoolOptions& options)
+    : stop_(false) {
+  bool is_spread = options.spread_over_numa_nodes && GetNumaNodeCount() > 1;
   for (size_t i = 0; i < threads; ++i)
-    workers_.emplace_back([this] {
+    workers_.emplace_back([this, is_spread, i] {
+      if (is_spread) {
+        SpreadCurrentWorker(i);
+      }
       for (;;) {
         std::function<void()> task;
         std::pair<coro::EventLoopID, coro::UserEvent*> task_event;
@@ -84,10 +105,42 @@ ThreadPool::ThreadPool(size_t threads) : stop_(false) {
 }
 
 ThreadPool& ThreadPool::GetInstance() {
-  static ThreadPool pool(std::thread::hardware_concurrency());
+  static ThreadPool pool(std::thread::hardware_concurrency(),
+                         TakeGlobalOptions());
   return pool;
 }
 
+void ThreadPool::SetGlobalOptions(const ThreadPoolOptions& options) {
+  std::lock_guard guard(global_options_lock);
+  if (is_instance_created) {
+    throw arc::exception::detail::ExceptionBase(
+        "Thread pool options must be set before the thread pool is created");
+  }
+  global_options = options;
+}
+
+void ThreadPool::SpreadCurrentWorker(size_t index) {
+  // runs close to the memory of loops on every node
+  int node = index % GetNumaNodeCount();
+  auto allowed_cpus = GetAllowedCpus();
+  std::vector<int> cpus;
+  for (int cpu : GetCpusOfNumaNode(node)) {
+    if (std::binary_search(allowed_cpus.begin(), allowed_cpus.end(), cpu)) {
+      cpus.push_back(cpu);
+    }
+  }
+  if (cpus.empty()) {
+    return;
+  }
+  try {
+    SetCurrentThreadAffinity(cpus);
+    SetCurrentThreadPreferredNumaNode(node);
+  } catch (const arc::exception::detail::ExceptionBase&) {
+    // e.g. the node is not allowed by the cpuset, the worker still serves
+    // unpinned
+  }
+}
+
 // the destructor joins all threads
 ThreadPool::~ThreadPool() {
   {
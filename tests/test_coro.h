@@ -32,9 +32,15 @@
 #include "utils.h"
 
 #include <arc/coro/eventloop.h>
+#include <arc/coro/generator.h>
 #include <arc/coro/task.h>
+#include <arc/coro/utils/when.h>
 #include <gtest/gtest.h>
 
+#include <thread>
+#include <utility>
+#include <vector>
+
 namespace arc {
 namespace test {
 
@@ -71,6 +77,16 @@ class BasicCoroTest : public ::testing::Test {
     EXPECT_EQ(ret, 100000);
   }
 
+  coro::Task<int> PooledFrame(int value) { co_return value; }
+
+  coro::Task<void> FramePoolTestCoro(int count) {
+    int ret = 0;
+    for (int i = 0; i < count; i++) {
+      ret += co_await PooledFrame(1);
+    }
+    EXPECT_EQ(count, ret);
+  }
+
   coro::Task<void> RecursiveTestCoro() {
     int ret = co_await ReturnInt(10000);
     EXPECT_EQ(ret, 50005000);
@@ -110,6 +126,148 @@ class BasicCoroTest : public ::testing::Test {
 
   void Fail() { FAIL() << "Expected std::logic_error"; }
 
+  int finished_count_{0};
+
+  coro::Task<int> SleepAndReturn(int milliseconds, int value) {
+    co_await coro::SleepFor(std::chrono::milliseconds(milliseconds));
+    finished_count_++;
+    co_return value;
+  }
+
+  coro::Task<void> SleepAndCount(int milliseconds) {
+    co_await coro::SleepFor(std::chrono::milliseconds(milliseconds));
+    finished_count_++;
+  }
+
+  coro::Task<int> SleepAndThrow(int milliseconds, const char* message) {
+    co_await coro::SleepFor(std::chrono::milliseconds(milliseconds));
+    throw std::logic_error(message);
+  }
+
+  coro::Task<void> WhenAllTestCoro() {
+    auto [sum, nothing, one] = co_await coro::WhenAll(
+        ReturnInt(3), SleepAndCount(2), SleepAndReturn(1, 1));
+    EXPECT_EQ(6, sum);
+    EXPECT_EQ(1, one);
+    EXPECT_EQ(2, finished_count_);
+
+    std::vector<coro::Task<int>> tasks;
+    for (int i = 0; i < 10; i++) {
+      tasks.push_back(SleepAndReturn(10 - i, i));
+    }
+    auto results = co_await coro::WhenAll(std::move(tasks));
+    EXPECT_EQ(10, results.size());
+    for (int i = 0; i < 10; i++) {
+      EXPECT_EQ(i, results[i]);
+    }
+
+    // the exception comes after every task has finished
+    finished_count_ = 0;
+    std::vector<coro::Task<int>> failing_tasks;
+    failing_tasks.push_back(SleepAndReturn(2, 0));
+    failing_tasks.push_back(ReturnInt(-1));
+    try {
+      co_await coro::WhenAll(std::move(failing_tasks));
+      Fail();
+    } catch (std::logic_error const& err) {
+      EXPECT_EQ(1, finished_count_);
+    }
+
+    // the first failure in argument order wins, not the first to finish
+    try {
+      co_await coro::WhenAll(SleepAndThrow(2, "first"),
+                             SleepAndThrow(1, "second"));
+      Fail();
+    } catch (std::logic_error const& err) {
+      EXPECT_STREQ("first", err.what());
+    }
+  }
+
+  coro::Task<void> WhenAnyTestCoro() {
+    auto result = co_await coro::WhenAny(
+        SleepAndReturn(30, 0), SleepAndReturn(1, 1), SleepAndReturn(20, 2));
+    EXPECT_EQ(1, result.index);
+    EXPECT_EQ(1, result.value);
+    EXPECT_EQ(1, finished_count_);
+
+    std::vector<coro::Task<void>> tasks;
+    tasks.push_back(SleepAndCount(5));
+    tasks.push_back(SleepAndCount(50));
+    auto void_result = co_await coro::WhenAny(std::move(tasks));
+    EXPECT_EQ(0, void_result.index);
+  }
+
+  // counts when it is destroyed as a parameter of a destroyed frame
+  struct DestructionCounter {
+    int* count;
+    DestructionCounter(int* count) : count(count) {}
+    DestructionCounter(DestructionCounter&& other)
+        : count(std::exchange(other.count, nullptr)) {}
+    ~DestructionCounter() {
+      if (count != nullptr) {
+        (*count)++;
+      }
+    }
+  };
+
+  // suspends until the test resumes the handle by hand
+  struct ManualAwaiter {
+    std::coroutine_handle<>& handle;
+    bool await_ready() { return false; }
+    void await_suspend(std::coroutine_handle<> suspended) {
+      handle = suspended;
+    }
+    void await_resume() {}
+  };
+
+  coro::Task<void> SuspendOnce(DestructionCounter counter,
+                               std::coroutine_handle<>& handle) {
+    co_await ManualAwaiter{handle};
+    // the copy in the frame only goes away with the frame
+    EXPECT_EQ(0, *counter.count);
+  }
+
+  coro::Generator<int> Range(int begin, int end) {
+    for (int i = begin; i < end; i++) {
+      if (i < 0) {
+        throw std::logic_error("Error input");
+      }
+      co_yield i;
+    }
+  }
+
+  coro::AsyncGenerator<int> SleepyRange(int begin, int end) {
+    for (int i = begin; i < end; i++) {
+      co_await coro::SleepFor(std::chrono::milliseconds(1));
+      if (i < 0) {
+        throw std::logic_error("Error input");
+      }
+      co_yield i;
+    }
+  }
+
+  coro::Task<void> AsyncGeneratorTestCoro() {
+    int sum = 0;
+    auto stream = SleepyRange(0, 10);
+    for (auto itr = co_await stream.begin(); itr != stream.end();
+         co_await ++itr) {
+      sum += *itr;
+    }
+    EXPECT_EQ(45, sum);
+
+    auto empty_stream = SleepyRange(0, 0);
+    auto itr = co_await empty_stream.begin();
+    EXPECT_TRUE(itr == empty_stream.end());
+
+    auto failing_stream = SleepyRange(-1, 10);
+    try {
+      co_await failing_stream.begin();
+      Fail();
+    } catch (std::logic_error const& err) {
+      EXPECT_EQ(err.what(), std::string("Error input"));
+    }
+  }
+
   coro::Task<void> ExceptionTestCoro() {
     try {
       int ret = co_await ReturnInt(-1);
@@ -139,6 +297,69 @@ TEST_F(BasicCoroTest, ExceptionTest) {
   coro::StartEventLoop(ExceptionTestCoro());
 }
 
+TEST_F(BasicCoroTest, WhenAllTest) { coro::StartEventLoop(WhenAllTestCoro()); }
+
+TEST_F(BasicCoroTest, WhenAnyTest) {
+  coro::StartEventLoop(WhenAnyTestCoro());
+  // the loop runs until the tasks which lost have finished
+  EXPECT_EQ(5, finished_count_);
+}
+
+TEST_F(BasicCoroTest, DetachedTaskTest) {
+  int destroyed_count = 0;
+  std::coroutine_handle<> handle = nullptr;
+  coro::EnsureFuture(SuspendOnce(&destroyed_count, handle));
+  EXPECT_EQ(0, destroyed_count);
+  // the frame goes away as soon as it finishes, without an event loop
+  handle.resume();
+  EXPECT_EQ(1, destroyed_count);
+}
+
+TEST_F(BasicCoroTest, GeneratorTest) {
+  int sum = 0;
+  for (int i : Range(0, 10)) {
+    sum += i;
+  }
+  EXPECT_EQ(45, sum);
+  EXPECT_THROW(
+      {
+        for (int i : Range(-1, 10)) {
+          sum += i;
+        }
+      },
+      std::logic_error);
+}
+
+TEST_F(BasicCoroTest, AsyncGeneratorTest) {
+  coro::StartEventLoop(AsyncGeneratorTestCoro());
+}
+
+TEST_F(BasicCoroTest, FramePoolTest) {
+  constexpr int kFrames = 64;
+  auto stats = coro::FramePool::GetLocalStats();
+  FramePoolTestCoro(1000).Start();
+  auto new_stats = coro::FramePool::GetLocalStats();
+  EXPECT_GT(new_stats.pool_hits - stats.pool_hits,
+            (new_stats.allocations - stats.allocations) * 99 / 100);
+
+  // frames finished on another thread go back to the pool of this thread
+  stats = new_stats;
+  std::vector<coro::Task<int>> tasks;
+  for (int i = 0; i < kFrames; i++) {
+    tasks.push_back(ReturnInt(1));
+  }
+  std::thread thread([&tasks]() {
+    for (auto& task : tasks) {
+      task.Start();
+    }
+    tasks.clear();
+  });
+  thread.join();
+  new_stats = coro::FramePool::GetLocalStats();
+  EXPECT_EQ(new_stats.remote_deallocations - stats.remote_deallocations,
+            kFrames);
+}
+
 }  // namespace test
 }  // namespace arc
 
@@ -30,6 +30,8 @@
 
 #include <arc/coro/locks/condition.h>
 #include <arc/coro/task.h>
+#include <arc/coro/utils/task_group.h>
+#include <arc/io/socket.h>
 #include <gtest/gtest.h>
 
 #include "utils.h"
@@ -87,6 +89,91 @@ class CancelCoroTest : public ::testing::Test {
     }
   }
 
+  int interrupted_count_ = 0;
+
+  coro::Task<void> WaitUntilCancelled(const coro::CancellationToken& token) {
+    co_await cond_.Wait(token);
+    interrupted_count_++;
+  }
+
+  coro::Task<void> SleepAndThrow(int milliseconds) {
+    co_await coro::SleepFor(std::chrono::milliseconds(milliseconds));
+    throw std::logic_error("Error input");
+  }
+
+  coro::Task<void> SleepAndCancel(int milliseconds) {
+    co_await coro::SleepFor(std::chrono::milliseconds(milliseconds));
+    token_.Cancel();
+  }
+
+  coro::Task<void> TaskGroupFailureCoro() {
+    coro::TaskGroup group;
+    for (int i = 0; i < 4; i++) {
+      group.Spawn(WaitUntilCancelled(group.GetToken()));
+    }
+    group.Spawn(SleepAndThrow(5));
+    try {
+      co_await group.Wait();
+      ADD_FAILURE() << "Expected std::logic_error";
+    } catch (std::logic_error const& err) {
+      EXPECT_EQ(4, interrupted_count_);
+      EXPECT_TRUE(group.IsCancelled());
+    }
+
+    // waits started after the cancellation are interrupted right away
+    group.Spawn(WaitUntilCancelled(group.GetToken()));
+    co_await group.Wait();
+    EXPECT_EQ(5, interrupted_count_);
+  }
+
+  coro::Task<void> TaskGroupCancelCoro() {
+    coro::TaskGroup group(token_);
+    for (int i = 0; i < 4; i++) {
+      group.Spawn(WaitUntilCancelled(group.GetToken()));
+    }
+    coro::EnsureFuture(SleepAndCancel(5));
+    co_await group.Wait();
+    EXPECT_EQ(4, interrupted_count_);
+  }
+
+  coro::Task<void> CancelledRecvCoro() {
+    using SocketType =
+        io::Socket<net::Domain::IPV4, net::Protocol::TCP, io::Pattern::ASYNC>;
+    io::Acceptor<net::Domain::IPV4, io::Pattern::ASYNC> acceptor;
+    acceptor.SetOption(net::SocketOption::REUSEADDR, 1);
+    acceptor.Bind({"localhost", 0});
+    acceptor.Listen();
+    SocketType sock;
+    co_await sock.Connect({"localhost", acceptor.GetLocalAddress().GetPort()});
+    auto accepted = co_await acceptor.Accept();
+    token_.Cancel();
+    // nothing else is registered to the loop, so only the interruption can
+    // end the wait
+    char buf[1];
+    EXPECT_LT(co_await accepted.Recv(buf, 1, token_), 0);
+    interrupted_count_++;
+  }
+
+  coro::Task<void> CancelledAcceptCoro() {
+    io::Acceptor<net::Domain::IPV4, io::Pattern::ASYNC> acceptor;
+    acceptor.SetOption(net::SocketOption::REUSEADDR, 1);
+    acceptor.Bind({"localhost", 0});
+    acceptor.Listen();
+    coro::EnsureFuture(SleepAndCancel(5));
+    try {
+      co_await acceptor.Accept(token_);
+      ADD_FAILURE() << "Expected arc::exception::IOException";
+    } catch (const arc::exception::IOException&) {
+      interrupted_count_++;
+    }
+
+    // the acceptor still works afterwards
+    io::Socket<net::Domain::IPV4, net::Protocol::TCP, io::Pattern::ASYNC> sock;
+    co_await sock.Connect({"localhost", acceptor.GetLocalAddress().GetPort()});
+    auto accepted = co_await acceptor.Accept();
+    EXPECT_GE(accepted.GetFd(), 0);
+  }
+
   void MultiThreadMutilpleRunConditionCancel(int thread_num, int per_thread_num, bool will_be_self_released) {
     std::vector<std::thread> threads;
     for (int i = 0; i < thread_num; i++) {
@@ -109,6 +196,24 @@ TEST_F(CancelCoroTest, TestConditionCancelTriggered) {
   MultiThreadMutilpleRunConditionCancel(10, 100, false);
 }
 
+TEST_F(CancelCoroTest, TaskGroupFailureTest) {
+  coro::StartEventLoop(TaskGroupFailureCoro());
+}
+
+TEST_F(CancelCoroTest, TaskGroupCancelTest) {
+  coro::StartEventLoop(TaskGroupCancelCoro());
+}
+
+TEST_F(CancelCoroTest, CancelledIOWaitTest) {
+  coro::StartEventLoop(CancelledRecvCoro());
+  EXPECT_EQ(1, interrupted_count_);
+}
+
+TEST_F(CancelCoroTest, CancelledAcceptTest) {
+  coro::StartEventLoop(CancelledAcceptCoro());
+  EXPECT_EQ(1, interrupted_count_);
+}
+
 }  // namespace test
 }  // namespace arc
 
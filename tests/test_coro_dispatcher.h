@@ -31,10 +31,17 @@
 
 #include <arc/coro/dispatcher.h>
 #include <arc/coro/locks/condition.h>
+#include <arc/coro/runtime.h>
 #include <arc/coro/task.h>
 #include "utils.h"
 
 #include <gtest/gtest.h>
+#include <sys/eventfd.h>
+
+#include <atomic>
+#include <map>
+#include <thread>
+#include <vector>
 
 namespace arc {
 namespace test {
@@ -46,6 +53,10 @@ class DispatcherCoroTest : public ::testing::Test {
   coro::Condition consumer_prepare_cond_;
   int finished_produce_count_{0};
   int prepared_consumer_count_{0};
+  std::atomic<int> blocking_task_count_{0};
+  std::atomic<bool> is_holding_{false};
+  std::atomic<bool> is_released_{false};
+  std::atomic<int> bounded_task_count_{0};
 
  public:
   coro::Task<void> DispatchedTask() {
@@ -54,6 +65,109 @@ class DispatcherCoroTest : public ::testing::Test {
     counter++;
   }
 
+  coro::Task<void> BlockingTask() {
+    // blocks the whole event loop like a slow request
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    GetThreadLocalCounter()++;
+    blocking_task_count_++;
+    co_return;
+  }
+
+  coro::Task<void> HoldingTask() {
+    is_holding_ = true;
+    while (!is_released_) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    co_return;
+  }
+
+  coro::Task<void> BoundedTask() {
+    bounded_task_count_++;
+    co_return;
+  }
+
+  coro::Task<void> ReleaseWhenFullTask(std::uint64_t rejected_enqueues) {
+    auto& dispatcher = coro::CoroutineDispatcher::GetInstance();
+    while (dispatcher.GetStats().rejected_enqueues == rejected_enqueues) {
+      co_await coro::SleepFor(std::chrono::milliseconds(1));
+    }
+    is_released_ = true;
+  }
+
+  coro::Task<void> BoundedProducerTask(coro::EventLoopWakeUpHandle consumer_id,
+                                       int count) {
+    auto& dispatcher = coro::CoroutineDispatcher::GetInstance();
+    bool is_dispatched =
+        co_await coro::BoundedDispatchTo(HoldingTask(), consumer_id);
+    EXPECT_TRUE(is_dispatched);
+    // the consumer is blocked with an empty queue from now on
+    while (!is_holding_) {
+      co_await coro::SleepFor(std::chrono::milliseconds(1));
+    }
+    coro::EnsureFuture(
+        ReleaseWhenFullTask(dispatcher.GetStats().rejected_enqueues));
+    for (int i = 0; i < count; i++) {
+      is_dispatched =
+          co_await coro::BoundedDispatchTo(BoundedTask(), consumer_id);
+      EXPECT_TRUE(is_dispatched);
+    }
+  }
+
+  coro::Task<void> MovedTask(coro::EventLoopWakeUpHandle consumer_id) {
+    co_await coro::ResumeOn(consumer_id);
+    EXPECT_EQ(consumer_id, coro::EventLoop::GetLocalInstance().GetEventHandle());
+    bounded_task_count_++;
+  }
+
+  coro::Task<void> ResumeOnProducerTask(coro::EventLoopWakeUpHandle consumer_id,
+                                        int count) {
+    auto& dispatcher = coro::CoroutineDispatcher::GetInstance();
+    co_await coro::BoundedDispatchTo(HoldingTask(), consumer_id);
+    while (!is_holding_) {
+      co_await coro::SleepFor(std::chrono::milliseconds(1));
+    }
+    coro::EnsureFuture(
+        ReleaseWhenFullTask(dispatcher.GetStats().rejected_enqueues));
+    for (int i = 0; i < count; i++) {
+      coro::EnsureFuture(MovedTask(consumer_id));
+    }
+  }
+
+  coro::Task<void> StealingConsumerTask(int total_count) {
+    co_await lock_.Acquire();
+    coro::EventLoop::GetLocalInstance().ResigerConsumer();
+    prepared_consumer_count_++;
+    consumer_prepare_cond_.NotifyAll();
+    lock_.Release();
+
+    while (blocking_task_count_ < total_count) {
+      co_await coro::SleepFor(std::chrono::milliseconds(1));
+    }
+    coro::EventLoop::GetLocalInstance().DeResigerConsumer();
+  }
+
+  coro::Task<void> BatchedProduceTask(int produce_count, int consumer_count) {
+    coro::EventLoop::GetLocalInstance().ResigerProducer();
+    co_await lock_.Acquire();
+    while (prepared_consumer_count_ < consumer_count) {
+      co_await consumer_prepare_cond_.Wait(lock_);
+    }
+    lock_.Release();
+    // all of them are dispatched to one consumer in a single batch
+    for (int i = 0; i < produce_count; i++) {
+      coro::EventLoop::GetLocalInstance().Dispatch(BlockingTask());
+    }
+    coro::EventLoop::GetLocalInstance().DeResigerProducer();
+  }
+
+  void StartStealingConsumerTask(int total_count, int* consumed_count) {
+    coro::EventLoopOptions options;
+    options.work_stealing = true;
+    coro::EventLoop::SetLocalOptions(options);
+    coro::StartEventLoop(StealingConsumerTask(total_count));
+    *consumed_count = GetThreadLocalCounter();
+  }
+
   coro::Task<void> LongRunTask(int producer_count) {
     co_await lock_.Acquire();
     coro::EventLoop::GetLocalInstance().ResigerConsumer();
@@ -170,6 +284,274 @@ TEST_F(DispatcherCoroTest, BiasedDispatchTest) {
   }
 }
 
+TEST_F(DispatcherCoroTest, WorkStealingTest) {
+  prepared_consumer_count_ = 0;
+  blocking_task_count_ = 0;
+  int consumer_count = 2;
+  int total_count = 20;
+  std::vector<int> consumed_counts(consumer_count, 0);
+  std::vector<std::thread> consumer_threads;
+  for (int i = 0; i < consumer_count; i++) {
+    consumer_threads.emplace_back(
+        &DispatcherCoroTest::StartStealingConsumerTask, this, total_count,
+        &consumed_counts[i]);
+  }
+  std::thread producer_thread([this, total_count, consumer_count]() {
+    coro::StartEventLoop(BatchedProduceTask(total_count, consumer_count));
+  });
+
+  producer_thread.join();
+  for (int i = 0; i < consumer_count; i++) {
+    consumer_threads[i].join();
+  }
+  EXPECT_EQ(total_count, consumed_counts[0] + consumed_counts[1]);
+  // the idle consumer should have stolen some from the busy one
+  EXPECT_GT(consumed_counts[0], 0);
+  EXPECT_GT(consumed_counts[1], 0);
+}
+
+TEST_F(DispatcherCoroTest, BoundedDispatchTest) {
+  coro::RuntimeOptions options;
+  options.thread_count = 1;
+  coro::Runtime runtime(options);
+  auto consumer_id = runtime.GetEventHandle(0);
+  // the producer has to wait for the blocked consumer at least once
+  int count = 1500;
+  std::thread producer([&]() {
+    coro::StartEventLoop(BoundedProducerTask(consumer_id, count));
+  });
+  producer.join();
+  EXPECT_TRUE(is_released_);
+  while (bounded_task_count_ < count) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_LE(coro::CoroutineDispatcher::GetInstance().GetHighWaterMark(
+                consumer_id),
+            1024);
+  runtime.Shutdown();
+  runtime.Join();
+  EXPECT_EQ(count, bounded_task_count_);
+}
+
+TEST_F(DispatcherCoroTest, SleepingConsumerWakeUpTest) {
+  auto& dispatcher = coro::CoroutineDispatcher::GetInstance();
+  coro::RuntimeOptions options;
+  options.thread_count = 1;
+  coro::Runtime runtime(options);
+  auto wait_for_count = [this](int count) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while (bounded_task_count_ < count &&
+           std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    return bounded_task_count_ == count;
+  };
+
+  // a burst only wakes up the consumer once in a while
+  auto stats = dispatcher.GetStats();
+  int count = 1000;
+  for (int i = 0; i < count; i++) {
+    runtime.Spawn(BoundedTask());
+  }
+  EXPECT_TRUE(wait_for_count(count));
+  auto new_stats = dispatcher.GetStats();
+  EXPECT_LE(new_stats.notifications - stats.notifications,
+            new_stats.enqueues - stats.enqueues);
+
+  // a single dispatch to a consumer parked in polling is never lost
+  for (int i = 0; i < 20; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(i % 2 == 0 ? 20 : 0));
+    stats = dispatcher.GetStats();
+    runtime.Spawn(BoundedTask());
+    count++;
+    EXPECT_TRUE(wait_for_count(count));
+    if (i % 2 == 0) {
+      new_stats = dispatcher.GetStats();
+      EXPECT_EQ(1, new_stats.notifications - stats.notifications);
+    }
+  }
+  runtime.Shutdown();
+  runtime.Join();
+}
+
+TEST_F(DispatcherCoroTest, ResumeOnFullQueueTest) {
+  coro::RuntimeOptions options;
+  options.thread_count = 1;
+  coro::Runtime runtime(options);
+  auto consumer_id = runtime.GetEventHandle(0);
+  // more coroutines move over than the queue of the blocked consumer holds
+  int count = 1500;
+  std::thread producer([&]() {
+    coro::StartEventLoop(ResumeOnProducerTask(consumer_id, count));
+  });
+  producer.join();
+  EXPECT_TRUE(is_released_);
+  while (bounded_task_count_ < count) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_LE(coro::CoroutineDispatcher::GetInstance().GetHighWaterMark(
+                consumer_id),
+            1024);
+  runtime.Shutdown();
+  runtime.Join();
+  EXPECT_EQ(count, bounded_task_count_);
+}
+
+TEST_F(DispatcherCoroTest, ResumeOnUnregisteredTest) {
+  auto task = []() -> coro::Task<void> {
+    EXPECT_THROW(co_await coro::ResumeOn(-1),
+                 arc::exception::detail::ExceptionBase);
+  };
+  coro::StartEventLoop(task());
+}
+
+TEST_F(DispatcherCoroTest, KeyAffineDispatchTest) {
+  auto& dispatcher = coro::CoroutineDispatcher::GetInstance();
+  std::vector<coro::EventLoopWakeUpHandle> ids;
+  std::map<coro::EventLoopWakeUpHandle, coro::CoroutineQueue*> queues;
+  for (int i = 0; i < 3; i++) {
+    ids.push_back(eventfd(0, EFD_NONBLOCK));
+    queues[ids.back()] = dispatcher.Register(ids.back());
+  }
+
+  int key_count = 300;
+  std::vector<coro::EventLoopWakeUpHandle> owners;
+  std::map<coro::EventLoopWakeUpHandle, int> key_counts;
+  for (int key = 0; key < key_count; key++) {
+    owners.push_back(dispatcher.GetConsumerByKey(key));
+    key_counts[owners.back()]++;
+    EXPECT_TRUE(dispatcher.EnqueueToKey(key, std::noop_coroutine()));
+  }
+  EXPECT_EQ(3, key_counts.size());
+  for (auto& [id, queue] : queues) {
+    EXPECT_EQ(key_counts[id], queue->GetRemainedItemsCount());
+    queue->DequeAll(queue->GetRemainedItemsCount());
+  }
+
+  // a new consumer only takes keys from others
+  ids.push_back(eventfd(0, EFD_NONBLOCK));
+  dispatcher.Register(ids.back());
+  for (int key = 0; key < key_count; key++) {
+    auto owner = dispatcher.GetConsumerByKey(key);
+    if (owner != owners[key]) {
+      EXPECT_EQ(ids.back(), owner);
+    }
+  }
+
+  // a leaving consumer only gives away its own keys
+  dispatcher.DeRegister(ids.back());
+  dispatcher.DeRegister(ids[0]);
+  for (int key = 0; key < key_count; key++) {
+    auto owner = dispatcher.GetConsumerByKey(key);
+    if (owners[key] != ids[0]) {
+      EXPECT_EQ(owners[key], owner);
+    } else {
+      EXPECT_NE(ids[0], owner);
+    }
+  }
+
+  dispatcher.DeRegister(ids[1]);
+  dispatcher.DeRegister(ids[2]);
+  for (auto id : ids) {
+    close(id);
+  }
+}
+
+TEST_F(DispatcherCoroTest, KeyedDeRegisterTest) {
+  auto& dispatcher = coro::CoroutineDispatcher::GetInstance();
+  std::vector<coro::EventLoopWakeUpHandle> ids;
+  std::map<coro::EventLoopWakeUpHandle, coro::CoroutineQueue*> queues;
+  for (int i = 0; i < 3; i++) {
+    ids.push_back(eventfd(0, EFD_NONBLOCK));
+    queues[ids.back()] = dispatcher.Register(ids.back());
+  }
+  int key_count = 300;
+  for (int key = 0; key < key_count; key++) {
+    EXPECT_TRUE(dispatcher.EnqueueToKey(key, std::noop_coroutine()));
+    // unkeyed ones are spread without following any key
+    EXPECT_TRUE(dispatcher.EnqueueToAny(std::noop_coroutine()));
+  }
+
+  // the keyed coroutines still queued follow their keys to the new owners
+  dispatcher.DeRegister(ids[0]);
+  queues.erase(ids[0]);
+  int keyed_count = 0;
+  int total_count = 0;
+  for (auto [id, queue] : queues) {
+    total_count += queue->GetRemainedItemsCount();
+    for (auto& [key, handle] : queue->DequeAllKeyed()) {
+      EXPECT_EQ(id, dispatcher.GetConsumerByKey(key));
+      keyed_count++;
+    }
+  }
+  EXPECT_EQ(key_count, keyed_count);
+  EXPECT_EQ(key_count * 2, total_count);
+
+  dispatcher.DeRegister(ids[1]);
+  dispatcher.DeRegister(ids[2]);
+  for (auto id : ids) {
+    close(id);
+  }
+}
+
+TEST_F(DispatcherCoroTest, RegistrationChurnTest) {
+  auto& dispatcher = coro::CoroutineDispatcher::GetInstance();
+  auto stable_id = eventfd(0, EFD_NONBLOCK);
+  auto stable_queue = dispatcher.Register(stable_id);
+
+  // producers keep reading snapshots which are replaced and freed meanwhile
+  int producer_count = 4;
+  int per_producer_count = 200;
+  std::vector<std::thread> producer_threads;
+  for (int i = 0; i < producer_count; i++) {
+    producer_threads.emplace_back([&dispatcher, per_producer_count]() {
+      for (int j = 0; j < per_producer_count; j++) {
+        EXPECT_TRUE(dispatcher.EnqueueToAny(std::noop_coroutine()));
+      }
+    });
+  }
+  for (int i = 0; i < 100; i++) {
+    auto id = eventfd(0, EFD_NONBLOCK);
+    dispatcher.Register(id);
+    // what is left in the queue goes to the stable consumer
+    dispatcher.DeRegister(id);
+    close(id);
+  }
+  for (auto& thread : producer_threads) {
+    thread.join();
+  }
+  EXPECT_EQ(producer_count * per_producer_count,
+            stable_queue->GetRemainedItemsCount());
+
+  dispatcher.DeRegister(stable_id);
+  close(stable_id);
+}
+
+TEST_F(DispatcherCoroTest, LeastQueuedPolicyTest) {
+  auto& dispatcher = coro::CoroutineDispatcher::GetInstance();
+  std::vector<coro::EventLoopWakeUpHandle> ids;
+  std::vector<coro::CoroutineQueue*> queues;
+  for (int i = 0; i < 3; i++) {
+    ids.push_back(eventfd(0, EFD_NONBLOCK));
+    queues.push_back(dispatcher.Register(ids.back()));
+  }
+
+  EXPECT_TRUE(dispatcher.EnqueueToSpecific(ids[0], std::noop_coroutine()));
+  EXPECT_TRUE(dispatcher.EnqueueToSpecific(ids[0], std::noop_coroutine()));
+  for (int i = 0; i < 4; i++) {
+    EXPECT_TRUE(dispatcher.EnqueueToAny(std::noop_coroutine(),
+                                        coro::DispatchPolicy::LEAST_QUEUED));
+  }
+  for (auto queue : queues) {
+    EXPECT_EQ(2, queue->GetRemainedItemsCount());
+  }
+
+  for (auto id : ids) {
+    dispatcher.DeRegister(id);
+    close(id);
+  }
+}
+
 }  // namespace test
 }  // namespace arc
 
@@ -31,6 +31,7 @@
 
 #include <arc/coro/task.h>
 #include <arc/coro/utils/executor.h>
+#include <arc/utils/thread_pool.h>
 #include <gtest/gtest.h>
 
 #include "utils.h"
@@ -96,6 +97,15 @@ TEST_F(ExecutorCoroTest, TestTotalTime) {
               used_time * max_allowed_ref_error_);
 }
 
+TEST_F(ExecutorCoroTest, ThreadPoolOptionsTest) {
+  // workers are created once, so options given later would be ignored
+  utils::ThreadPool::GetInstance();
+  utils::ThreadPoolOptions options;
+  options.spread_over_numa_nodes = true;
+  EXPECT_THROW(utils::ThreadPool::SetGlobalOptions(options),
+               arc::exception::detail::ExceptionBase);
+}
+
 }  // namespace test
 }  // namespace arc
 
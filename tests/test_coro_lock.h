@@ -72,6 +72,33 @@ class LockCoroTest : public ::testing::Test {
     }
   }
 
+  int finished_coros_ = 0;
+
+  arc::coro::Task<void> YieldingLockCoro(int num) {
+    for (int i = 0; i < num; i++) {
+      co_await lock_.Acquire();
+      lock_value_++;
+      co_await arc::coro::Yield();
+      EXPECT_EQ(lock_value_, 1);
+      lock_value_--;
+      lock_.Release();
+    }
+    finished_coros_++;
+  }
+
+  arc::coro::Task<void> LocalHandoffCoro(int num, int per_num) {
+    auto& loop = arc::coro::EventLoop::GetLocalInstance();
+    auto time_events = loop.GetProfile().time_events;
+    for (int i = 0; i < num; i++) {
+      arc::coro::EnsureFuture(YieldingLockCoro(per_num));
+    }
+    while (finished_coros_ < num) {
+      co_await arc::coro::Yield();
+    }
+    // yields and lock handoffs on the same loop never reach the timers
+    EXPECT_EQ(time_events, loop.GetProfile().time_events);
+  }
+
   arc::coro::Task<void> CondCoro() {
     co_await lock_.Acquire();
     co_await cond_.Wait(lock_);
@@ -152,6 +179,10 @@ TEST_F(LockCoroTest, BasicLockMultiThreadTest) {
               (elapsed * max_allowed_ref_error_));
 }
 
+TEST_F(LockCoroTest, LocalHandoffTest) {
+  arc::coro::StartEventLoop(LocalHandoffCoro(10, 100));
+}
+
 TEST_F(LockCoroTest, BasicCondMultiThreadTest) {
   int thread_num = 20;
   int run_times = 20;
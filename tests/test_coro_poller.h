@@ -0,0 +1,396 @@
+/*
+ * File: test_coro_poller.h
+ * Project: libarc
+ * File Created: Sunday, 18th October 2026 1:35:07 am
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef LIBARC__TESTS__TEST_CORO_POLLER_H
+#define LIBARC__TESTS__TEST_CORO_POLLER_H
+
+#include "utils.h"
+
+#include <arc/coro/eventloop.h>
+#include <arc/coro/locks/condition.h>
+#include <arc/coro/task.h>
+#include <arc/io/socket.h>
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+
+#include <thread>
+
+namespace arc {
+namespace test {
+
+template <coro::PollerType PT, bool ET = false>
+class PollerCoroTestTypeTrait {
+ public:
+  constexpr static coro::PollerType poller_type = PT;
+  constexpr static bool edge_triggered = ET;
+};
+
+template <typename T>
+class PollerCoroTest : public ::testing::Test {
+ protected:
+  using SocketType =
+      io::Socket<net::Domain::IPV4, net::Protocol::TCP, io::Pattern::ASYNC>;
+  using AcceptorType = io::Acceptor<net::Domain::IPV4, io::Pattern::ASYNC>;
+
+  constexpr static int kClientsCount_ = 16;
+  constexpr static int kRoundsPerClient_ = 64;
+  constexpr static int kMessageLength_ = 512;
+  constexpr static int kSleepTime_ = 100;
+  constexpr static int kShortSleepTimeUs_ = 200;
+  constexpr static int kShortSleepRounds_ = 50;
+  constexpr static int kHighFd_ = 5000;
+
+  float max_allowed_ref_error_ = 0.1;
+  std::uint16_t port_{0};
+  int echoed_rounds_{0};
+  coro::Condition cond_;
+
+  virtual void SetUp() override {
+    if (IsRunningWithValgrind()) {
+      max_allowed_ref_error_ = 1;
+    }
+  }
+
+  // runs the task on a fresh thread whose event loop uses the tested poller
+  void RunOnPoller(const std::function<coro::Task<void>()>& task,
+                   coro::EventLoopOptions options = {}) {
+    options.poller_type = T::poller_type;
+    options.epoll_edge_triggered = T::edge_triggered;
+    std::thread thread([&task, &options]() {
+      coro::EventLoop::SetLocalOptions(options);
+      coro::StartEventLoop(task());
+    });
+    thread.join();
+  }
+
+  coro::Task<void> HandleClient(SocketType client) {
+    // read less than a message at a time so that one readiness notification
+    // is followed by several reads
+    char buf[kMessageLength_];
+    constexpr int kBytesPerRead = kMessageLength_ / 4 + 1;
+    while (true) {
+      int received = 0;
+      while (received < kMessageLength_) {
+        int recv = co_await client.Recv(
+            buf + received, std::min(kBytesPerRead, kMessageLength_ - received));
+        if (recv <= 0) {
+          co_return;
+        }
+        received += recv;
+      }
+      int sent = co_await client.Send(buf, received);
+      EXPECT_EQ(sent, received);
+    }
+  }
+
+  coro::Task<void> ClientEcho(int client_id) {
+    SocketType sock;
+    co_await sock.Connect({"localhost", port_});
+    std::string message(kMessageLength_, 'a' + client_id % 26);
+    char buf[kMessageLength_];
+    for (int i = 0; i < kRoundsPerClient_; i++) {
+      int sent = co_await sock.Send(message.c_str(), message.size());
+      EXPECT_EQ(sent, kMessageLength_);
+      int received = 0;
+      while (received < kMessageLength_) {
+        int recv = co_await sock.Recv(buf + received, kMessageLength_ - received);
+        EXPECT_GT(recv, 0);
+        if (recv <= 0) {
+          co_return;
+        }
+        received += recv;
+      }
+      EXPECT_EQ(std::string(buf, kMessageLength_), message);
+      echoed_rounds_++;
+    }
+  }
+
+  coro::Task<void> Echo() {
+    AcceptorType acceptor;
+    acceptor.SetOption(arc::net::SocketOption::REUSEADDR, 1);
+    acceptor.Bind({"localhost", 0});
+    acceptor.Listen();
+    port_ = acceptor.GetLocalAddress().GetPort();
+
+    for (int i = 0; i < kClientsCount_; i++) {
+      coro::EnsureFuture(ClientEcho(i));
+    }
+    for (int i = 0; i < kClientsCount_; i++) {
+      coro::EnsureFuture(HandleClient(co_await acceptor.Accept()));
+    }
+  }
+
+  coro::Task<void> TimeAndUserEvents() {
+    std::int64_t elapsed = 0;
+    auto now = std::chrono::steady_clock::now();
+    co_await coro::SleepFor(std::chrono::milliseconds(kSleepTime_));
+    elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                  std::chrono::steady_clock::now() - now)
+                  .count();
+    EXPECT_NEAR(elapsed, kSleepTime_, kSleepTime_ * max_allowed_ref_error_);
+
+    // a condition notified from another thread triggers a user event
+    std::thread notifier([this]() {
+      std::this_thread::sleep_for(std::chrono::milliseconds(kSleepTime_));
+      cond_.NotifyAll();
+    });
+    now = std::chrono::steady_clock::now();
+    co_await cond_.Wait();
+    elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                  std::chrono::steady_clock::now() - now)
+                  .count();
+    notifier.join();
+    EXPECT_NEAR(elapsed, kSleepTime_, kSleepTime_ * max_allowed_ref_error_);
+
+    // an io event interrupted by its timeout
+    AcceptorType acceptor;
+    acceptor.SetOption(arc::net::SocketOption::REUSEADDR, 1);
+    acceptor.Bind({"localhost", 0});
+    acceptor.Listen();
+    SocketType sock;
+    co_await sock.Connect({"localhost", acceptor.GetLocalAddress().GetPort()});
+    char buf[16];
+    now = std::chrono::steady_clock::now();
+    int recv = co_await sock.Recv(buf, sizeof(buf),
+                                  std::chrono::milliseconds(kSleepTime_));
+    elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                  std::chrono::steady_clock::now() - now)
+                  .count();
+    EXPECT_LT(recv, 0);
+    EXPECT_NEAR(elapsed, kSleepTime_, kSleepTime_ * max_allowed_ref_error_);
+  }
+
+  coro::Task<void> ShortSleeps() {
+    auto now = std::chrono::steady_clock::now();
+    for (int i = 0; i < kShortSleepRounds_; i++) {
+      auto sleep_start = std::chrono::steady_clock::now();
+      co_await coro::SleepFor(std::chrono::microseconds(kShortSleepTimeUs_));
+      // a tick of the wheel is one microsecond
+      EXPECT_GE(std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - sleep_start)
+                        .count(),
+                kShortSleepTimeUs_ - 1);
+    }
+    std::int64_t elapsed =
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - now)
+            .count();
+    // millisecond timers would take at least 1ms for each of the sleeps
+    EXPECT_LT(elapsed / kShortSleepRounds_,
+              kShortSleepTimeUs_ * (2 + 10 * max_allowed_ref_error_));
+  }
+
+  coro::Task<void> SpeculativeEcho() {
+    co_await Echo();
+    while (echoed_rounds_ < kClientsCount_ * kRoundsPerClient_) {
+      co_await coro::SleepFor(std::chrono::milliseconds(1));
+    }
+    // sends of small messages never block
+    auto& stats = coro::EventLoop::GetLocalInstance().GetSpeculativeIOStats();
+    EXPECT_GE(stats.inline_completions, kClientsCount_ * kRoundsPerClient_);
+    EXPECT_GT(stats.HitRate(), 0);
+  }
+
+  coro::Task<void> ProfiledEcho() {
+    co_await Echo();
+    while (echoed_rounds_ < kClientsCount_ * kRoundsPerClient_) {
+      co_await coro::SleepFor(std::chrono::milliseconds(1));
+    }
+    auto profile = coro::EventLoop::GetLocalInstance().GetProfile();
+    EXPECT_GT(profile.iterations, 0);
+    EXPECT_GE(profile.io_events, 2 * kClientsCount_ * kRoundsPerClient_);
+    EXPECT_GT(profile.time_events, 0);
+    EXPECT_GT(profile.poller_control_calls, 0);
+    // the current iteration is still running
+    EXPECT_EQ(profile.wait.count, profile.iterations);
+    EXPECT_EQ(profile.trim.count + 1, profile.iterations);
+    EXPECT_GE(profile.wait.Percentile(0.99), profile.wait.Percentile(0.5));
+    EXPECT_LE(profile.wait.Percentile(1), profile.wait.max_ns);
+  }
+
+  coro::Task<void> EchoOnHighFd() {
+    AcceptorType acceptor;
+    acceptor.SetOption(arc::net::SocketOption::REUSEADDR, 1);
+    acceptor.Bind({"localhost", 0});
+    acceptor.Listen();
+    port_ = acceptor.GetLocalAddress().GetPort();
+    coro::EnsureFuture(ClientEcho(0));
+    auto accepted = co_await acceptor.Accept();
+    // serve the client with a duplicate far above the initial fd table
+    int high_fd = fcntl(accepted.GetFd(), F_DUPFD_CLOEXEC, kHighFd_);
+    EXPECT_GE(high_fd, kHighFd_);
+    co_await HandleClient(SocketType(high_fd, accepted.GetLocalAddress()));
+  }
+
+  coro::Task<void> SteadyStateAllocations() {
+    AcceptorType acceptor;
+    acceptor.SetOption(arc::net::SocketOption::REUSEADDR, 1);
+    acceptor.Bind({"localhost", 0});
+    acceptor.Listen();
+    SocketType sock;
+    co_await sock.Connect({"localhost", acceptor.GetLocalAddress().GetPort()});
+    coro::EnsureFuture(HandleClient(co_await acceptor.Accept()));
+
+    auto& loop = coro::EventLoop::GetLocalInstance();
+    coro::EventAllocatorStats warmed_up_stats{};
+    std::string message(kMessageLength_, 'a');
+    char buf[kMessageLength_];
+    for (int i = 0; i < 2 * kRoundsPerClient_; i++) {
+      if (i == kRoundsPerClient_) {
+        warmed_up_stats = loop.GetEventAllocatorStats();
+      }
+      co_await sock.Send(message.c_str(), message.size());
+      int received = 0;
+      while (received < kMessageLength_) {
+        int recv = co_await sock.Recv(buf + received, kMessageLength_ - received,
+                                      std::chrono::milliseconds(kSleepTime_));
+        EXPECT_GT(recv, 0);
+        if (recv <= 0) {
+          co_return;
+        }
+        received += recv;
+      }
+      co_await coro::Yield();
+    }
+    auto stats = loop.GetEventAllocatorStats();
+    EXPECT_EQ(stats.heap_allocations, warmed_up_stats.heap_allocations);
+    EXPECT_GT(stats.reused_allocations, warmed_up_stats.reused_allocations);
+  }
+
+  coro::Task<void> WaitOnInvalidFd() {
+    SocketType sock;
+    SocketType moved = std::move(sock);
+    char buf[1];
+    EXPECT_THROW(co_await sock.Recv(buf, 1), arc::exception::IOException);
+  }
+
+  coro::Task<void> SendLater(SocketType& sock) {
+    co_await coro::SleepFor(std::chrono::milliseconds(1));
+    co_await sock.Send("a", 1);
+  }
+
+  coro::Task<void> ReuseClosedFd() {
+    AcceptorType acceptor;
+    acceptor.SetOption(arc::net::SocketOption::REUSEADDR, 1);
+    acceptor.Bind({"localhost", 0});
+    acceptor.Listen();
+    std::uint16_t port = acceptor.GetLocalAddress().GetPort();
+    SocketType sock;
+    co_await sock.Connect({"localhost", port});
+    auto accepted = co_await acceptor.Accept();
+    char buf[1];
+    // leaves the fd watched by the poller
+    EXPECT_LT(co_await accepted.Recv(buf, 1, std::chrono::milliseconds(1)), 0);
+    int closed_fd = accepted.GetFd();
+    // the socket is closed on another thread, so this poller is not told
+    std::thread([](SocketType) {}, std::move(accepted)).join();
+
+    SocketType reused;
+    EXPECT_EQ(reused.GetFd(), closed_fd);
+    co_await reused.Connect({"localhost", port});
+    auto reused_accepted = co_await acceptor.Accept();
+    coro::EnsureFuture(SendLater(reused_accepted));
+    auto now = std::chrono::steady_clock::now();
+    EXPECT_EQ(co_await reused.Recv(buf, 1, std::chrono::milliseconds(
+                                               kSleepTime_)),
+              1);
+    // the readiness is reported instead of being found after the timeout
+    EXPECT_LT(std::chrono::steady_clock::now() - now,
+              std::chrono::milliseconds(kSleepTime_));
+  }
+};
+
+using PollerTestTypes =
+    ::testing::Types<PollerCoroTestTypeTrait<coro::PollerType::EPOLL>,
+                     PollerCoroTestTypeTrait<coro::PollerType::EPOLL, true>,
+                     PollerCoroTestTypeTrait<coro::PollerType::IO_URING>>;
+
+TYPED_TEST_CASE(PollerCoroTest, PollerTestTypes);
+
+TYPED_TEST(PollerCoroTest, EchoTest) {
+  this->RunOnPoller([this]() { return this->Echo(); });
+  EXPECT_EQ(this->echoed_rounds_,
+            this->kClientsCount_ * this->kRoundsPerClient_);
+}
+
+TYPED_TEST(PollerCoroTest, TimeAndUserEventTest) {
+  this->RunOnPoller([this]() { return this->TimeAndUserEvents(); });
+}
+
+TYPED_TEST(PollerCoroTest, HighFdTest) {
+  this->RunOnPoller([this]() { return this->EchoOnHighFd(); });
+  EXPECT_EQ(this->echoed_rounds_, this->kRoundsPerClient_);
+}
+
+TYPED_TEST(PollerCoroTest, EventAllocationTest) {
+  this->RunOnPoller([this]() { return this->SteadyStateAllocations(); });
+}
+
+TYPED_TEST(PollerCoroTest, FdReuseTest) {
+  this->RunOnPoller([this]() { return this->ReuseClosedFd(); });
+}
+
+TYPED_TEST(PollerCoroTest, InvalidFdTest) {
+  this->RunOnPoller([this]() { return this->WaitOnInvalidFd(); });
+}
+
+TYPED_TEST(PollerCoroTest, HighResolutionTimerTest) {
+  coro::EventLoopOptions options;
+  options.high_resolution_timer = true;
+  this->RunOnPoller([this]() { return this->TimeAndUserEvents(); }, options);
+  this->RunOnPoller([this]() { return this->ShortSleeps(); }, options);
+}
+
+TYPED_TEST(PollerCoroTest, BusyPollTest) {
+  coro::EventLoopOptions options;
+  options.busy_poll_us = 200;
+  this->RunOnPoller([this]() { return this->Echo(); }, options);
+  EXPECT_EQ(this->echoed_rounds_,
+            this->kClientsCount_ * this->kRoundsPerClient_);
+  this->RunOnPoller([this]() { return this->TimeAndUserEvents(); }, options);
+}
+
+TYPED_TEST(PollerCoroTest, ProfileTest) {
+  coro::EventLoopOptions options;
+  options.profile_timing = true;
+  this->RunOnPoller([this]() { return this->ProfiledEcho(); }, options);
+}
+
+TYPED_TEST(PollerCoroTest, SpeculativeIOTest) {
+  coro::EventLoopOptions options;
+  options.speculative_io = true;
+  this->RunOnPoller([this]() { return this->SpeculativeEcho(); }, options);
+  EXPECT_EQ(this->echoed_rounds_,
+            this->kClientsCount_ * this->kRoundsPerClient_);
+}
+
+}  // namespace test
+}  // namespace arc
+
+#endif
@@ -0,0 +1,78 @@
+/*
+ * File: test_coro_ring_buffer.h
+ * Project: libarc
+ * File Created: Sunday, 18th October 2026 3:37:03 am
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef LIBARC__TESTS__TEST_CORO_RING_BUFFER_H
+#define LIBARC__TESTS__TEST_CORO_RING_BUFFER_H
+
+#include <arc/coro/utils/ring_buffer.h>
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace arc {
+namespace test {
+
+TEST(RingBufferTest, WrapAndGrowTest) {
+  coro::RingBuffer<int> buffer(4);
+  EXPECT_EQ(4, buffer.Capacity());
+  int next_push = 0;
+  int next_pop = 0;
+  buffer.PushBack(next_push++);
+  // keep the buffer partly filled so that it wraps around before growing
+  for (int round = 0; round < 3; round++) {
+    for (int i = 0; i < 2; i++) {
+      buffer.PushBack(next_push++);
+    }
+    EXPECT_EQ(next_pop++, buffer.Front());
+    buffer.PopFront();
+    EXPECT_EQ(next_pop++, buffer.Front());
+    buffer.PopFront();
+  }
+  EXPECT_EQ(1, buffer.Size());
+  EXPECT_EQ(4, buffer.Capacity());
+
+  for (int i = 0; i < 12; i++) {
+    buffer.PushBack(next_push++);
+  }
+  EXPECT_EQ(16, buffer.Capacity());
+  std::vector<int> popped;
+  while (!buffer.Empty()) {
+    auto segment = buffer.FrontSegment();
+    popped.insert(popped.end(), segment.begin(), segment.end());
+    buffer.PopFront(segment.size());
+  }
+  for (int value : popped) {
+    EXPECT_EQ(next_pop++, value);
+  }
+  EXPECT_EQ(next_push, next_pop);
+}
+
+}  // namespace test
+}  // namespace arc
+
+#endif
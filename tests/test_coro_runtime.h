@@ -0,0 +1,357 @@
+/*
+ * File: test_coro_runtime.h
+ * Project: libarc
+ * File Created: Sunday, 18th October 2026 2:58:32 am
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef LIBARC__TESTS__TEST_CORO_RUNTIME_H
+#define LIBARC__TESTS__TEST_CORO_RUNTIME_H
+
+#include <arc/coro/runtime.h>
+#include <arc/coro/utils/task_group.h>
+#include <arc/utils/cpu.h>
+#include <arpa/inet.h>
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <sched.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace arc {
+namespace test {
+
+class RuntimeCoroTest : public ::testing::Test {
+ protected:
+  using SocketType =
+      io::Socket<net::Domain::IPV4, net::Protocol::TCP, io::Pattern::ASYNC>;
+
+  std::atomic<int> finished_count_{0};
+  std::mutex lock_;
+  std::set<std::thread::id> thread_ids_;
+
+ public:
+  coro::Task<void> CountTask() {
+    co_await coro::Yield();
+    {
+      std::lock_guard guard(lock_);
+      thread_ids_.insert(std::this_thread::get_id());
+    }
+    finished_count_++;
+  }
+
+  coro::Task<void> PlacementTask(int index, std::vector<int>& cpus,
+                                 std::vector<int>& numa_nodes) {
+    co_await coro::Yield();
+    cpus[index] = sched_getcpu();
+    numa_nodes[index] = coro::EventLoop::GetLocalInstance().GetNumaNode();
+    finished_count_++;
+  }
+
+  coro::Task<void> LoopInfoTask(int index,
+                                std::vector<std::thread::id>& loop_threads,
+                                std::vector<coro::EventLoopID>& loop_ids) {
+    loop_threads[index] = std::this_thread::get_id();
+    loop_ids[index] = coro::EventLoop::GetLocalInstance().GetEventLoopID();
+    finished_count_++;
+    co_return;
+  }
+
+  coro::Task<void> HopTask(coro::Runtime& runtime,
+                           std::vector<std::thread::id>& loop_threads,
+                           std::vector<coro::EventLoopID>& loop_ids) {
+    for (int i = 0; i < 4; i++) {
+      int index = i % 2;
+      if (i < 2) {
+        co_await coro::ResumeOn(runtime.GetEventHandle(index));
+      } else {
+        co_await coro::ResumeOnEventLoop(loop_ids[index]);
+      }
+      if (std::this_thread::get_id() == loop_threads[index]) {
+        finished_count_++;
+      }
+    }
+  }
+
+  coro::Task<void> TaskGroupTask(coro::Runtime& runtime) {
+    coro::TaskGroup group;
+    for (int i = 0; i < runtime.GetThreadCount(); i++) {
+      EXPECT_TRUE(
+          co_await group.SpawnOn(CountTask(), runtime.GetEventHandle(i)));
+    }
+    co_await group.Wait();
+    EXPECT_EQ(runtime.GetThreadCount(), finished_count_);
+    runtime.Shutdown();
+  }
+
+  coro::Task<void> ShutdownTask(coro::Runtime& runtime) {
+    co_await coro::SleepFor(std::chrono::milliseconds(1));
+    finished_count_++;
+    runtime.Shutdown();
+  }
+
+  static coro::Task<void> Echo(SocketType sock) {
+    char buf[64];
+    while (true) {
+      int received = co_await sock.Recv(buf, sizeof(buf));
+      if (received <= 0) {
+        break;
+      }
+      co_await sock.Send(buf, received);
+    }
+  }
+
+  coro::Task<void> StreamServeTask(
+      io::Acceptor<net::Domain::IPV4, io::Pattern::ASYNC>& acceptor,
+      int connection_count, std::string& received) {
+    auto connections = acceptor.AcceptStream();
+    auto itr = co_await connections.begin();
+    for (int i = 0; i < connection_count; i++) {
+      if (i > 0) {
+        co_await ++itr;
+      }
+      auto& sock = *itr;
+      char buf[64];
+      auto chunks = sock.RecvStream(buf, sizeof(buf));
+      for (auto chunk = co_await chunks.begin(); chunk != chunks.end();
+           co_await ++chunk) {
+        received.append(buf, *chunk);
+        co_await sock.Send(buf, *chunk);
+      }
+    }
+    finished_count_++;
+  }
+
+  coro::Task<void> ResetStreamTask(
+      io::Acceptor<net::Domain::IPV4, io::Pattern::ASYNC>& acceptor) {
+    auto sock = co_await acceptor.Accept();
+    char buf[64];
+    auto chunks = sock.RecvStream(buf, sizeof(buf));
+    bool is_thrown = false;
+    try {
+      for (auto chunk = co_await chunks.begin(); chunk != chunks.end();
+           co_await ++chunk) {
+      }
+    } catch (const arc::exception::IOException&) {
+      is_thrown = true;
+    }
+    EXPECT_TRUE(is_thrown);
+    finished_count_++;
+  }
+
+  // a blocking client which does not touch the event loop of this thread
+  std::string EchoOnce(std::uint16_t port, const std::string& data) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    std::string received;
+    if (connect(fd, (sockaddr*)&addr, sizeof(addr)) == 0 &&
+        send(fd, data.data(), data.size(), 0) ==
+            static_cast<ssize_t>(data.size())) {
+      char buf[64];
+      while (received.size() < data.size()) {
+        int ret = recv(fd, buf, sizeof(buf), 0);
+        if (ret <= 0) {
+          break;
+        }
+        received.append(buf, ret);
+      }
+    }
+    close(fd);
+    return received;
+  }
+};
+
+TEST_F(RuntimeCoroTest, SpawnTest) {
+  coro::RuntimeOptions options;
+  options.thread_count = 2;
+  coro::Runtime runtime(options);
+  EXPECT_EQ(2, runtime.GetThreadCount());
+  int task_count = 20;
+  for (int i = 0; i < task_count; i++) {
+    runtime.Spawn(CountTask());
+  }
+  while (finished_count_ < task_count) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  runtime.Shutdown();
+  runtime.Join();
+  EXPECT_EQ(task_count, finished_count_);
+  EXPECT_EQ(2, thread_ids_.size());
+  EXPECT_THROW(runtime.Spawn(CountTask()),
+               arc::exception::detail::ExceptionBase);
+}
+
+TEST_F(RuntimeCoroTest, PinThreadsTest) {
+  coro::RuntimeOptions options;
+  options.thread_count = 2;
+  options.pin_threads = true;
+  options.event_loop_options.numa_local_memory = true;
+  options.event_loop_options.prefer_local_numa_consumers = true;
+  coro::Runtime runtime(options);
+  std::vector<int> cpus(2, -1);
+  std::vector<int> numa_nodes(2, -1);
+  runtime.SpawnOnEachLoop([&](int index) {
+    return PlacementTask(index, cpus, numa_nodes);
+  });
+  while (finished_count_ < 2) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  runtime.Shutdown();
+  runtime.Join();
+  auto allowed_cpus = utils::GetAllowedCpus();
+  for (int i = 0; i < 2; i++) {
+    int cpu = allowed_cpus[i % allowed_cpus.size()];
+    EXPECT_EQ(cpu, cpus[i]);
+    EXPECT_EQ(utils::GetNumaNodeOfCpu(cpu), numa_nodes[i]);
+  }
+}
+
+TEST_F(RuntimeCoroTest, ResumeOnTest) {
+  coro::RuntimeOptions options;
+  options.thread_count = 2;
+  coro::Runtime runtime(options);
+  std::vector<std::thread::id> loop_threads(2);
+  std::vector<coro::EventLoopID> loop_ids(2, -1);
+  runtime.SpawnOnEachLoop([&](int index) {
+    return LoopInfoTask(index, loop_threads, loop_ids);
+  });
+  while (finished_count_ < 2) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  runtime.Spawn(HopTask(runtime, loop_threads, loop_ids));
+  while (finished_count_ < 6) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  runtime.Shutdown();
+  runtime.Join();
+  EXPECT_EQ(6, finished_count_);
+}
+
+TEST_F(RuntimeCoroTest, RunTest) {
+  coro::RuntimeOptions options;
+  options.thread_count = 2;
+  coro::Runtime runtime(options);
+  runtime.Run(ShutdownTask(runtime));
+  EXPECT_EQ(1, finished_count_);
+  EXPECT_TRUE(runtime.IsShutdown());
+}
+
+TEST_F(RuntimeCoroTest, TaskGroupTest) {
+  coro::RuntimeOptions options;
+  options.thread_count = 4;
+  coro::Runtime runtime(options);
+  runtime.Run(TaskGroupTask(runtime));
+  EXPECT_EQ(4, thread_ids_.size());
+}
+
+TEST_F(RuntimeCoroTest, ReusePortServeTest) {
+  coro::RuntimeOptions options;
+  options.thread_count = 2;
+  options.pin_threads = true;
+  coro::Runtime runtime(options);
+  std::vector<net::Address<net::Domain::IPV4>> addrs;
+  for (bool is_cpu_steering : {false, true}) {
+    auto addr = runtime.Serve(net::Address<net::Domain::IPV4>("127.0.0.1", 0),
+                              &RuntimeCoroTest::Echo, is_cpu_steering);
+    EXPECT_NE(0, addr.GetPort());
+    for (int i = 0; i < 8; i++) {
+      std::string data = "hello " + std::to_string(i);
+      EXPECT_EQ(data, EchoOnce(addr.GetPort(), data));
+    }
+    addrs.push_back(addr);
+  }
+  runtime.Shutdown();
+  runtime.Join();
+  for (auto& addr : addrs) {
+    // fails while any listener of the reuseport group is still open
+    io::Acceptor<net::Domain::IPV4, io::Pattern::ASYNC> acceptor;
+    acceptor.SetOption(net::SocketOption::REUSEADDR, 1);
+    EXPECT_NO_THROW(acceptor.Bind(addr));
+  }
+}
+
+TEST_F(RuntimeCoroTest, CpuSteeringRequiresPinningTest) {
+  coro::RuntimeOptions options;
+  options.thread_count = 1;
+  coro::Runtime runtime(options);
+  EXPECT_THROW(
+      runtime.Serve(net::Address<net::Domain::IPV4>("127.0.0.1", 0),
+                    &RuntimeCoroTest::Echo, true),
+      arc::exception::detail::ExceptionBase);
+}
+
+TEST_F(RuntimeCoroTest, StreamServeTest) {
+  io::Acceptor<net::Domain::IPV4, io::Pattern::ASYNC> acceptor;
+  acceptor.SetOption(net::SocketOption::REUSEADDR, 1);
+  acceptor.Bind(net::Address<net::Domain::IPV4>("127.0.0.1", 0));
+  acceptor.Listen();
+  auto port = acceptor.GetLocalAddress().GetPort();
+  std::thread client([this, port]() {
+    EXPECT_EQ("hello", EchoOnce(port, "hello"));
+    EXPECT_EQ("world", EchoOnce(port, "world"));
+  });
+  std::string received;
+  coro::StartEventLoop(StreamServeTask(acceptor, 2, received));
+  client.join();
+  EXPECT_EQ("helloworld", received);
+  EXPECT_EQ(1, finished_count_);
+}
+
+TEST_F(RuntimeCoroTest, StreamResetTest) {
+  io::Acceptor<net::Domain::IPV4, io::Pattern::ASYNC> acceptor;
+  acceptor.SetOption(net::SocketOption::REUSEADDR, 1);
+  acceptor.Bind(net::Address<net::Domain::IPV4>("127.0.0.1", 0));
+  acceptor.Listen();
+  auto port = acceptor.GetLocalAddress().GetPort();
+  std::thread client([port]() {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    EXPECT_EQ(0, connect(fd, (sockaddr*)&addr, sizeof(addr)));
+    // closes with a reset, which is an error rather than the end of stream
+    linger no_linger{1, 0};
+    setsockopt(fd, SOL_SOCKET, SO_LINGER, &no_linger, sizeof(no_linger));
+    close(fd);
+  });
+  coro::StartEventLoop(ResetStreamTask(acceptor));
+  client.join();
+  EXPECT_EQ(1, finished_count_);
+}
+
+}  // namespace test
+}  // namespace arc
+
+#endif /* LIBARC__TESTS__TEST_CORO_RUNTIME_H */
@@ -0,0 +1,112 @@
+/*
+ * File: test_coro_timing_wheel.h
+ * Project: libarc
+ * File Created: Sunday, 18th October 2026 1:45:49 am
+ * Author: Minjun Xu (mjxu96@outlook.com)
+ * -----
+ * MIT License
+ * Copyright (c) 2020 Minjun Xu
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef LIBARC__TESTS__TEST_CORO_TIMING_WHEEL_H
+#define LIBARC__TESTS__TEST_CORO_TIMING_WHEEL_H
+
+#include <arc/coro/events/time_event.h>
+#include <arc/coro/utils/timing_wheel.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace arc {
+namespace test {
+
+class TimingWheelTest : public ::testing::Test {
+ protected:
+  const static int kEventsCount_ = 100000;
+
+  std::vector<std::unique_ptr<coro::TimeEvent>> events_;
+
+  coro::TimeEvent* NewEvent(std::int64_t wakeup_time) {
+    events_.push_back(std::make_unique<coro::TimeEvent>(wakeup_time, nullptr));
+    return events_.back().get();
+  }
+};
+
+TEST_F(TimingWheelTest, ExpireInOrderTest) {
+  std::int64_t start_time = 123456789;
+  coro::TimingWheel wheel(start_time);
+  std::mt19937_64 engine(0);
+  // cover every level and the far future beyond the wheel
+  std::uniform_int_distribution<int> shift_dist(0, 40);
+  std::vector<bool> is_removed;
+  std::int64_t max_wakeup_time = start_time;
+  for (int i = 0; i < kEventsCount_; i++) {
+    std::int64_t delay = engine() % (std::int64_t{1} << shift_dist(engine));
+    auto event = NewEvent(start_time + delay);
+    max_wakeup_time = std::max(max_wakeup_time, start_time + delay);
+    wheel.Add(event);
+    is_removed.push_back(i % 3 == 0);
+  }
+  for (int i = 0; i < kEventsCount_; i += 3) {
+    wheel.Remove(events_[i].get());
+  }
+  EXPECT_EQ(wheel.Size(), kEventsCount_ - (kEventsCount_ + 2) / 3);
+
+  std::int64_t current_time = start_time;
+  std::size_t expired_count = 0;
+  while (!wheel.Empty()) {
+    std::int64_t next_expire_time = wheel.GetNextExpireTime();
+    ASSERT_GE(next_expire_time, 0);
+    current_time = std::max(current_time, next_expire_time);
+    while (auto event = wheel.PopExpired(current_time)) {
+      // an event never expires early, nor later than the time it is due
+      EXPECT_LE(event->GetWakeupTime(), current_time);
+      EXPECT_EQ(event->GetWakeupTime(), next_expire_time);
+      expired_count++;
+    }
+  }
+  EXPECT_EQ(expired_count, kEventsCount_ - (kEventsCount_ + 2) / 3);
+  EXPECT_EQ(wheel.GetNextExpireTime(), -1);
+}
+
+TEST_F(TimingWheelTest, LateAdvanceTest) {
+  coro::TimingWheel wheel(0);
+  for (int i = 0; i < 1000; i++) {
+    wheel.Add(NewEvent(i * 7));
+  }
+  // advancing far later at once still expires everything in order
+  std::int64_t prev_wakeup_time = -1;
+  int expired_count = 0;
+  while (auto event = wheel.PopExpired(1000000)) {
+    EXPECT_GE(event->GetWakeupTime(), prev_wakeup_time);
+    prev_wakeup_time = event->GetWakeupTime();
+    expired_count++;
+  }
+  EXPECT_EQ(expired_count, 1000);
+  EXPECT_TRUE(wheel.Empty());
+}
+
+}  // namespace test
+}  // namespace arc
+
+#endif
@@ -31,8 +31,12 @@
 #include "test_coro_dispatcher.h"
 #include "test_coro_executor.h"
 #include "test_coro_lock.h"
+#include "test_coro_poller.h"
+#include "test_coro_ring_buffer.h"
+#include "test_coro_runtime.h"
 #include "test_coro_socket.h"
 #include "test_coro_timeout.h"
+#include "test_coro_timing_wheel.h"
 
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);